@@ -0,0 +1,66 @@
+/*
+ * atom_table.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: McHale Trotter
+ */
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <unordered_map>
+
+#include "atom_table.h"
+#include "lille_exception.h"
+
+using namespace std;
+
+
+atom_table& atom_table::table()
+{
+	static atom_table the_table;
+	return the_table;
+}
+
+
+int atom_table::intern(string_view s)
+{
+	atom_table& t = table();
+	auto existing = t.atoms.find(s);
+
+	if (existing != t.atoms.end())
+		return existing->second;
+
+	int atom = t.names.size();
+	t.names.emplace_back(s);
+	t.atoms.emplace(t.names.back(), atom);
+	return atom;
+}
+
+
+int atom_table::find(string_view s)
+{
+	atom_table& t = table();
+	auto existing = t.atoms.find(s);
+
+	if (existing != t.atoms.end())
+		return existing->second;
+	else
+		return no_atom;
+}
+
+
+string_view atom_table::name(int atom)
+{
+	atom_table& t = table();
+
+	if ((atom < 0) or (atom >= int(t.names.size())))
+		throw lille_exception("Illegal atom passed to atom_table::name.");
+	return t.names[atom];
+}
+
+
+int atom_table::size()
+{
+	return table().names.size();
+}
@@ -0,0 +1,36 @@
+/*
+ * atom_table.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: McHale Trotter
+ */
+
+#ifndef ATOM_TABLE_H_
+#define ATOM_TABLE_H_
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <unordered_map>
+
+using namespace std;
+
+class atom_table {
+// Interns identifier names. Every distinct (upper case) name is given a dense integer atom, so that identifiers can be
+// compared and looked up as integers rather than strings. There is one table for the whole compilation.
+private:
+	deque<string> names;					// names[a] is the name of atom a. A deque never moves its elements.
+	unordered_map<string_view, int> atoms;	// Atom of each name. Keys view the strings held in names.
+
+	static atom_table& table();				// The single table shared by the compiler.
+
+public:
+	static const int no_atom = -1;			// Returned by find() for a name that has never been interned.
+
+	static int intern(string_view s);		// Atom for the name s, creating a new atom if s has not been seen before.
+	static int find(string_view s);			// Atom for the name s, or no_atom if s has not been seen before.
+	static string_view name(int atom);		// Name of the atom. The view is valid for the rest of the compilation.
+	static int size();						// Number of atoms created so far.
+};
+
+#endif /* ATOM_TABLE_H_ */
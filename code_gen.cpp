@@ -0,0 +1,665 @@
+/*
+ * code_gen.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: McHale Trotter
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <utility>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+#include "code_gen.h"
+#include "lille_exception.h"
+
+using namespace std;
+
+
+static void put16(string& out, uint32_t n)
+{
+	out += char(n & 0xFF);
+	out += char((n >> 8) & 0xFF);
+}
+
+
+static void put32(string& out, uint32_t n)
+{
+	put16(out, n & 0xFFFF);
+	put16(out, n >> 16);
+}
+
+
+static uint32_t get16(const string& in, size_t at)
+{
+	return uint32_t(uint8_t(in[at])) | (uint32_t(uint8_t(in[at + 1])) << 8);
+}
+
+
+static uint32_t get32(const string& in, size_t at)
+{
+	return get16(in, at) | (get16(in, at + 2) << 16);
+}
+
+
+code_gen::code_gen()
+{
+	code.reserve(1024);
+	unresolved = 0;
+}
+
+
+int code_gen::emit(op_code op, int level, int arg, string_view comment)
+// Append an instruction and return its address.
+{
+	code.push_back(instruction{op, level, arg, 0.0, string_view(), comment});
+	return int(code.size());
+}
+
+
+int code_gen::emit_opr(opr_code opr, string_view comment)
+{
+	return emit(OPR, 0, int(opr), comment);
+}
+
+
+int code_gen::emit_real(float value, string_view comment)
+{
+	code.push_back(instruction{LCR, 0, 0, value, string_view(), comment});
+	return int(code.size());
+}
+
+
+int code_gen::emit_string(string_view value, string_view comment)
+{
+	code.push_back(instruction{LCS, 0, 0, 0.0, value, comment});
+	return int(code.size());
+}
+
+
+int code_gen::emit_string_copy(string value, string_view comment)
+{
+	made_strings.push_back(move(value));
+	return emit_string(made_strings.back(), comment);
+}
+
+
+bool code_gen::is_constant(int address)
+{
+	if ((address < 1) or (address > int(code.size())))
+		return false;
+	op_code op = code[address - 1].op;
+	return (op == LCI) or (op == LCR) or (op == LCS);
+}
+
+
+int code_gen::integer_constant(int address)
+{
+	return code.at(address - 1).arg;
+}
+
+
+float code_gen::real_constant(int address)
+{
+	return code.at(address - 1).real_arg;
+}
+
+
+string_view code_gen::string_constant(int address)
+{
+	return code.at(address - 1).text;
+}
+
+
+void code_gen::truncate(int address)
+{
+	if ((address < 1) or (address > next_address()))
+		throw lille_exception("Internal compiler error. Attempt to truncate code at " + to_string(address) + ".");
+	code.resize(address - 1);
+}
+
+
+int code_gen::new_label()
+{
+	labels.push_back(label{0, vector<int>()});
+	return int(labels.size()) - 1;
+}
+
+
+int code_gen::emit_jump(op_code op, int label, string_view comment)
+// Jump to a label. A backward jump is complete at once. A forward jump is added to the label's patch list.
+{
+	int address = emit(op, 0, labels.at(label).address, comment);
+	if (labels[label].address == 0)
+	{
+		labels[label].jumps.push_back(address);
+		unresolved++;
+	}
+	return address;
+}
+
+
+void code_gen::define_label(int label)
+// Place the label at the next address. The jumps already made to it are patched in place and the list is released.
+{
+	if (labels.at(label).address != 0)
+		throw lille_exception("Internal compiler error. Label " + to_string(label) + " defined twice.");
+	labels[label].address = next_address();
+	for (int jump : labels[label].jumps)
+		code[jump - 1].arg = labels[label].address;
+	unresolved -= int(labels[label].jumps.size());
+	vector<int>().swap(labels[label].jumps);
+}
+
+
+static bool is_frame_access(code_gen::op_code op)
+{
+	return (op == code_gen::LDV) or (op == code_gen::STO) or (op == code_gen::LDA) or
+		   (op == code_gen::RDI) or (op == code_gen::RDR);
+}
+
+
+bool code_gen::can_inline(int entry, int start, int finish)
+// The statements may not call the routine itself, call a routine declared inside it or a for loop compiled as a
+// routine (both are marked at level 0), reserve stack space or jump anywhere but within themselves or to halt.
+{
+	if ((start < 1) or (finish < start) or (finish > int(code.size())))
+		return false;
+	for (int address = start; address <= finish; address++)
+	{
+		const instruction& ins = code[address - 1];
+		if (((ins.op == MST) and (ins.level == 0)) or ((ins.op == CAL) and (ins.arg == entry)) or (ins.op == INC))
+			return false;
+		if (((ins.op == JMP) or (ins.op == JIF)) and (ins.arg != 0) and ((ins.arg < start) or (ins.arg > finish)))
+			return false;
+	}
+	return true;
+}
+
+
+void code_gen::emit_inline(int start, int finish, int base, int shift)
+// Words of the frame of the routine (level 0) move to the caller's frame. Other levels are shifted to count from the
+// caller. Jumps within the statements move with them. A return at the very end is dropped, since the copy simply
+// continues with the instruction after it.
+{
+	const instruction& last = code.at(finish - 1);
+	bool drop_last = (last.op == OPR) and ((last.arg == procedure_return) or (last.arg == function_return));
+	int copy = next_address();
+	int after = copy + (finish - start + 1) - (drop_last ? 1 : 0);
+
+	code.reserve(code.size() + (finish - start + 1));
+	for (int address = start; address <= finish - (drop_last ? 1 : 0); address++)
+	{
+		instruction ins = code[address - 1];
+
+		if (((ins.op == JMP) or (ins.op == JIF)) and (ins.arg != 0))
+			ins.arg = copy + (ins.arg - start);
+		else if ((ins.op == OPR) and ((ins.arg == procedure_return) or (ins.arg == function_return)))
+		{
+			ins.op = JMP;
+			ins.arg = after;
+			ins.comment = "Return from inlined routine.";
+		}
+		else if (ins.op == MST)
+			ins.level += shift;
+		else if (is_frame_access(ins.op) and (ins.level == 0))
+			ins.arg += base;
+		else if (is_frame_access(ins.op))
+			ins.level += shift;
+		code.push_back(ins);
+	}
+}
+
+
+int code_gen::next_address()
+{
+	return int(code.size()) + 1;
+}
+
+
+void code_gen::patch(int address, int arg)
+// Set the argument of an instruction emitted earlier. Used to fill in forward jumps and frame sizes once known.
+{
+	if ((address < 1) or (address > int(code.size())))
+		throw lille_exception("Internal compiler error. Attempt to patch instruction " + to_string(address) + ".");
+	code[address - 1].arg = arg;
+}
+
+
+int code_gen::size()
+{
+	return int(code.size());
+}
+
+
+string_view code_gen::mnemonic(op_code op)
+{
+	static constexpr string_view mnemonics[] = {
+		"CAL", "INC", "JIF", "JMP", "LCI", "LCR", "LCS", "LDA", "LDI", "LDV", "MST", "OPR", "RDI", "RDR", "STI", "STO"
+	};
+	return mnemonics[op];
+}
+
+
+void code_gen::write(string filename)
+// Write the program as PAL text. Each line holds the mnemonic, level and argument in fixed width columns followed
+// by the address and an explanation of the instruction. The whole file is formatted into one buffer and written
+// with a single write.
+{
+	string out;
+	string arg;
+	char number[32];
+
+	check_labels();
+
+	out.reserve(code.size() * 64);
+	for (size_t i = 0; i < code.size(); i++)
+	{
+		const instruction& ins = code[i];
+
+		if (ins.op == LCS)
+		{
+			arg = "'";
+			for (char c : ins.text)
+			{
+				arg += c;
+				if (c == '\'')
+					arg += c;		// A quote inside a PAL string is doubled.
+			}
+			arg += "'";
+		}
+		else if (ins.op == LCR)
+		{
+			snprintf(number, sizeof(number), "%.7g", ins.real_arg);
+			arg = number;
+			if (arg.find_first_of(".eEn") == string::npos)
+				arg += ".0";		// Keep a real looking like a real.
+		}
+		else
+			arg = to_string(ins.arg);
+
+		out += mnemonic(ins.op);
+		out.append(5 - mnemonic(ins.op).length(), ' ');
+		string level = to_string(ins.level);
+		out += level;
+		out.append(level.length() < 7 ? 7 - level.length() : 1, ' ');
+		out += arg;
+		out.append(arg.length() < 6 ? 13 - arg.length() : 7, ' ');
+		out += '(';
+		out += to_string(i + 1);
+		out += ") ";
+		out += ins.comment;
+		if (ins.comment.length() < 30)
+			out.append(30 - ins.comment.length(), ' ');
+		out += '\n';
+	}
+
+	ofstream code_file(filename, ios::out | ios::binary);
+	if (!code_file)
+		throw lille_exception("Unable to create code file \"" + filename + "\".");
+	code_file.write(out.data(), out.size());
+}
+
+
+void code_gen::check_labels()
+{
+	if (unresolved != 0)
+		throw lille_exception("Internal compiler error. " + to_string(unresolved) + " jumps to undefined labels.");
+}
+
+
+void code_gen::write_binary(string filename)
+// Write the program as a binary object. Each distinct LCS string is stored once in the pool, however often it is
+// loaded. The object is built in one buffer and written with a single write.
+{
+	string out;
+	string strings;
+	unordered_map<string_view, uint32_t> string_index;
+
+	check_labels();
+	out.reserve(binary_header_size + code.size() * binary_instruction_size);
+	out.append(binary_magic, 4);
+	put16(out, binary_version);
+	put16(out, binary_instruction_size);
+	put32(out, code.size());
+	put32(out, 0);								// Number of strings and size of the pool, filled in below.
+	put32(out, 0);
+
+	for (const instruction& ins : code)
+	{
+		uint32_t arg = uint32_t(ins.arg);
+
+		if (ins.op == LCR)
+			memcpy(&arg, &ins.real_arg, sizeof(arg));
+		else if (ins.op == LCS)
+		{
+			auto [entry, added] = string_index.try_emplace(ins.text, uint32_t(string_index.size()));
+			if (added)
+			{
+				put32(strings, ins.text.length());
+				strings.append(ins.text);
+			}
+			arg = entry->second;
+		}
+		if ((ins.level < INT16_MIN) or (ins.level > INT16_MAX))
+			throw lille_exception("Internal compiler error. Level " + to_string(ins.level) + " cannot be encoded.");
+
+		out += char(ins.op);
+		out += char(0);
+		put16(out, uint16_t(ins.level));
+		put32(out, arg);
+	}
+
+	string counts;
+	put32(counts, string_index.size());
+	put32(counts, strings.size());
+	out.replace(12, 8, counts);
+	out += strings;
+
+	ofstream code_file(filename, ios::out | ios::binary);
+	if (!code_file)
+		throw lille_exception("Unable to create code file \"" + filename + "\".");
+	code_file.write(out.data(), out.size());
+}
+
+
+void code_gen::read_binary(string filename)
+// Load a program written by write_binary(). The instructions have no comments.
+{
+	ifstream object_file(filename, ios::in | ios::binary);
+	if (!object_file)
+		throw lille_exception("Unable to open object file \"" + filename + "\".");
+	string in((istreambuf_iterator<char>(object_file)), istreambuf_iterator<char>());
+
+	if ((in.size() < binary_header_size) or (in.compare(0, 4, binary_magic) != 0))
+		throw lille_exception("\"" + filename + "\" is not a PAL object file.");
+	if ((get16(in, 4) != binary_version) or (get16(in, 6) != binary_instruction_size))
+		throw lille_exception("\"" + filename + "\" is a PAL object file of an unsupported version.");
+
+	size_t count = get32(in, 8);
+	size_t string_count = get32(in, 12);
+	size_t pool_size = get32(in, 16);
+	size_t pool_start = binary_header_size + count * binary_instruction_size;
+	if (in.size() != pool_start + pool_size)
+		throw lille_exception("PAL object file \"" + filename + "\" is truncated or corrupt.");
+
+	// The strings are kept in the pool, and LCS instructions refer to them.
+	pool = in.substr(pool_start);
+	vector<string_view> strings;
+	for (size_t at = 0; at < pool.size(); )
+	{
+		size_t length = (at + 4 <= pool.size()) ? get32(pool, at) : pool.size();
+		if (at + 4 + length > pool.size())
+			throw lille_exception("PAL object file \"" + filename + "\" has a corrupt string pool.");
+		strings.push_back(string_view(pool).substr(at + 4, length));
+		at += 4 + length;
+	}
+	if (strings.size() != string_count)
+		throw lille_exception("PAL object file \"" + filename + "\" has a corrupt string pool.");
+
+	code.clear();
+	labels.clear();
+	unresolved = 0;
+	code.reserve(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		size_t at = binary_header_size + i * binary_instruction_size;
+		op_code op = op_code(uint8_t(in[at]));
+		int level = int16_t(get16(in, at + 2));
+		uint32_t arg = get32(in, at + 4);
+
+		if (op > STO)
+			throw lille_exception("PAL object file \"" + filename + "\" holds an unknown instruction.");
+		if (op == LCR)
+		{
+			float value;
+			memcpy(&value, &arg, sizeof(value));
+			code.push_back(instruction{op, level, 0, value, string_view(), string_view()});
+		}
+		else if (op == LCS)
+		{
+			if (arg >= strings.size())
+				throw lille_exception("PAL object file \"" + filename + "\" refers to a missing string.");
+			code.push_back(instruction{op, level, 0, 0.0, strings[arg], string_view()});
+		}
+		else
+			code.push_back(instruction{op, level, int(int32_t(arg)), 0.0, string_view(), string_view()});
+	}
+}
+
+
+// Peephole rules, tried in order on each instruction of the program.
+const code_gen::peephole_rule code_gen::peephole_rules[] = {
+	{"inverted exit test", &code_gen::invert_exit_test},
+	{"jump threading", &code_gen::thread_jump},
+	{"jump to return", &code_gen::return_instead_of_jump},
+	{"jump to next instruction", &code_gen::remove_jump_to_next},
+	{"unreachable code", &code_gen::remove_unreachable},
+	{"self assignment", &code_gen::remove_self_assignment}
+};
+
+
+static bool is_jump(code_gen::op_code op)
+{
+	return (op == code_gen::JMP) or (op == code_gen::JIF) or (op == code_gen::CAL);
+}
+
+
+int code_gen::optimize()
+// Each pass removes the code that cannot be reached, applies every rule to every instruction, then compacts the
+// program. Passes are repeated until one changes nothing, since each step can expose more work for the others.
+{
+	int original_size = int(code.size());
+	bool changed;
+
+	check_labels();
+	do
+	{
+		changed = remove_unreachable_routines();
+		count_references();
+		for (int i = 0; i < int(code.size()); i++)
+			for (const peephole_rule& rule : peephole_rules)
+				if (!code[i].removed and (this->*rule.apply)(i))
+					changed = true;
+		compact();
+	} while (changed);
+
+	return original_size - int(code.size());
+}
+
+
+bool code_gen::remove_unreachable_routines()
+// Follow the control flow from the start of the program: jumps, both ways out of a JIF, calls and the return from
+// them, and the flow from one instruction to the next. Routines that are never called, such as unused predefined
+// functions or procedures called only by them, are never reached and are removed along with any other dead code.
+{
+	int n = int(code.size());
+	vector<bool> reached(n, false);
+	vector<int> work {1};
+	bool changed = false;
+
+	while (!work.empty())
+	{
+		int address = work.back();
+		work.pop_back();
+		if ((address < 1) or (address > n) or reached[address - 1])
+			continue;
+		reached[address - 1] = true;
+
+		const instruction& ins = code[address - 1];
+		if ((ins.op == JMP) or (ins.op == JIF) or (ins.op == CAL))
+			work.push_back(ins.arg);			// JMP 0 0 halts, and address 0 is ignored.
+		if ((ins.op == JMP) or ((ins.op == OPR) and ((ins.arg == procedure_return) or (ins.arg == function_return))))
+			continue;
+		work.push_back(address + 1);
+	}
+
+	for (int i = 0; i < n; i++)
+		if (!reached[i] and !code[i].removed)
+		{
+			code[i].removed = true;
+			changed = true;
+		}
+	return changed;
+}
+
+
+void code_gen::count_references()
+{
+	references.assign(code.size(), 0);
+	for (const instruction& ins : code)
+		if (is_jump(ins.op) and (ins.arg >= 1) and (ins.arg <= int(code.size())))
+			references[ins.arg - 1]++;
+}
+
+
+bool code_gen::thread_jump(int i)
+// A jump to an unconditional jump goes straight to the final target. JMP 0 0 halts, so a jump to it halts too.
+{
+	if ((code[i].op != JMP) and (code[i].op != JIF))
+		return false;
+
+	int target = code[i].arg;
+	for (size_t hops = 0; hops < code.size(); hops++)
+	{
+		if ((target < 1) or (target > int(code.size())))
+			break;
+		const instruction& next = code[target - 1];
+		if ((next.op != JMP) or next.removed or (next.arg == target))
+			break;
+		target = next.arg;
+	}
+	if (target == code[i].arg)
+		return false;
+	code[i].arg = target;
+	return true;
+}
+
+
+bool code_gen::return_instead_of_jump(int i)
+// A jump to a return returns at once.
+{
+	if ((code[i].op != JMP) or (code[i].arg < 1) or (code[i].arg > int(code.size())))
+		return false;
+
+	const instruction& target = code[code[i].arg - 1];
+	if ((target.op != OPR) or target.removed or ((target.arg != procedure_return) and (target.arg != function_return)))
+		return false;
+	code[i] = target;
+	return true;
+}
+
+
+bool code_gen::remove_jump_to_next(int i)
+{
+	if ((code[i].op != JMP) or (code[i].arg != i + 2))
+		return false;
+	code[i].removed = true;
+	return true;
+}
+
+
+bool code_gen::remove_unreachable(int i)
+// Nothing that follows a jump or a return is executed, up to the next instruction that is jumped to or called.
+{
+	bool transfer = (code[i].op == JMP) or
+					((code[i].op == OPR) and ((code[i].arg == procedure_return) or (code[i].arg == function_return)));
+	bool changed = false;
+
+	if (transfer)
+		for (int j = i + 1; (j < int(code.size())) and (references[j] == 0) and !code[j].removed; j++)
+		{
+			code[j].removed = true;
+			changed = true;
+		}
+	return changed;
+}
+
+
+bool code_gen::invert_exit_test(int i)
+// "exit when c" compiles to c, JIF over the next instruction, JMP out of the loop. When c ends with a comparison
+// or a NOT, the test is inverted and the exit becomes a single JIF. Neither jump may be a jump target.
+{
+	if ((i == 0) or (i + 1 >= int(code.size())))
+		return false;
+
+	instruction& test = code[i - 1];
+	instruction& skip = code[i];
+	instruction& leave = code[i + 1];
+
+	if ((skip.op != JIF) or (skip.arg != i + 3) or (leave.op != JMP) or leave.removed or test.removed or
+		(references[i] != 0) or (references[i + 1] != 0) or (test.op != OPR))
+		return false;
+
+	static constexpr pair<opr_code, opr_code> inverse[] = {
+		{equal, not_equal}, {not_equal, equal},
+		{less_than, greater_or_equal}, {greater_or_equal, less_than},
+		{greater_than, less_or_equal}, {less_or_equal, greater_than}
+	};
+
+	if (test.arg == logical_not)
+		test.removed = true;
+	else
+	{
+		const pair<opr_code, opr_code>* found = nullptr;
+		for (const auto& p : inverse)
+			if (test.arg == p.first)
+				found = &p;
+		if (found == nullptr)
+			return false;
+		test.arg = found->second;
+	}
+	skip.removed = true;
+	leave.op = JIF;
+	leave.comment = "Exit loop if the inverted test is false.";
+	return true;
+}
+
+
+bool code_gen::remove_self_assignment(int i)
+// LDV l o followed by STO l o leaves memory and the stack as they were.
+{
+	if ((i + 1 >= int(code.size())) or (code[i].op != LDV))
+		return false;
+
+	instruction& store = code[i + 1];
+	if ((store.op != STO) or store.removed or (store.level != code[i].level) or (store.arg != code[i].arg) or
+		(references[i + 1] != 0))
+		return false;
+	code[i].removed = true;
+	store.removed = true;
+	return true;
+}
+
+
+void code_gen::compact()
+// Drop the removed instructions and renumber every jump and call. A jump to a removed instruction goes to the next
+// instruction that is kept, which does the same since removed instructions have no effect when reached.
+{
+	int n = int(code.size());
+	vector<int> new_address(n + 2, 0);
+	int kept = 0;
+
+	for (int i = 0; i < n; i++)
+		if (!code[i].removed)
+			new_address[i + 1] = ++kept;
+	int next = kept + 1;
+	for (int address = n; address >= 1; address--)
+		if (code[address - 1].removed)
+			new_address[address] = next;
+		else
+			next = new_address[address];
+
+	for (instruction& ins : code)
+		if (is_jump(ins.op) and (ins.arg >= 1) and (ins.arg <= n))
+			ins.arg = new_address[ins.arg];
+
+	code.erase(remove_if(code.begin(), code.end(), [](const instruction& ins) { return ins.removed; }), code.end());
+}
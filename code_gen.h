@@ -0,0 +1,179 @@
+/*
+ * code_gen.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: McHale Trotter
+ */
+
+#ifndef CODE_GEN_H_
+#define CODE_GEN_H_
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+
+#include "lille_exception.h"
+
+using namespace std;
+
+class code_gen {
+// Holds the PAL program generated by the parser. Instructions are appended to one contiguous vector as the source
+// is parsed, and the whole program is written to the code file in a single write once compilation is complete.
+// Instructions are numbered from 1, as in the PAL machine. Address 0 halts the machine.
+//
+// Jumps are made to labels. A jump to a label that has not been defined yet is recorded in the label's patch list,
+// and every jump in the list is filled in when the label is defined, so code is generated in a single pass.
+//
+// A binary object holds the same program without the comments. All numbers are little endian.
+//		header			"PALB", version (2 bytes), instruction size (2 bytes), number of instructions (4 bytes),
+//						number of strings (4 bytes), size of the string pool (4 bytes)
+//		instructions	op (1 byte), unused (1 byte), level (2 bytes), argument (4 bytes). The argument of LCR holds
+//						the bits of the real and that of LCS the index of the string in the pool.
+//		string pool		length (4 bytes) and text of each distinct LCS string, in order of first use.
+//
+// optimize() removes the routines and code that cannot be reached from the start of the program, applies a table
+// of peephole rules to what is left, removes the instructions they make redundant and renumbers the addresses of
+// jumps and calls.
+public:
+	enum op_code {
+		CAL,		// CAL n a	Call the routine at address a, which has n parameters.
+		INC,		// INC 0 n	Reserve n words on top of the stack.
+		JIF,		// JIF 0 a	Jump to address a if the top of the stack is false.
+		JMP,		// JMP 0 a	Jump to address a.
+		LCI,		// LCI 0 i	Load integer constant i.
+		LCR,		// LCR 0 r	Load real constant r.
+		LCS,		// LCS 0 s	Load string constant s.
+		LDA,		// LDA l o	Load the address of the word at offset o, l static levels out.
+		LDI,		// LDI 0 0	Replace the address on top of the stack with the value it refers to.
+		LDV,		// LDV l o	Load the value of the word at offset o, l static levels out.
+		MST,		// MST l 0	Mark the stack for a call to a routine declared l static levels out.
+		OPR,		// OPR 0 n	Operation n, see opr_code.
+		RDI,		// RDI l o	Read an integer into the word at offset o, l static levels out.
+		RDR,		// RDR l o	Read a real into the word at offset o, l static levels out.
+		STI,		// STI 0 0	Store the value below the top of the stack at the address on top of the stack.
+		STO			// STO l o	Store the top of the stack in the word at offset o, l static levels out.
+	};
+
+	enum opr_code {
+		procedure_return = 0,
+		function_return = 1,
+		negate = 2,
+		add = 3,
+		subtract = 4,
+		multiply = 5,
+		divide = 6,
+		power = 7,
+		concatenate = 8,
+		odd = 9,
+		equal = 10,
+		not_equal = 11,
+		less_than = 12,
+		greater_or_equal = 13,
+		greater_than = 14,
+		less_or_equal = 15,
+		logical_or = 16,
+		logical_and = 17,
+		logical_not = 18,
+		write_value = 20,
+		write_line = 21,
+		duplicate = 23,
+		int_to_real = 25,
+		real_to_int = 26,
+		int_to_string = 27,
+		real_to_string = 28
+	};
+
+	code_gen();
+
+	int emit(op_code op, int level, int arg, string_view comment);
+	// Append an instruction and return its address.
+	int emit_opr(opr_code opr, string_view comment);					// Append OPR 0 opr.
+	int emit_real(float value, string_view comment);					// Append LCR 0 value.
+	int emit_string(string_view value, string_view comment);
+	// Append LCS 0 'value'. The text is not copied, so it must outlive the code generator (token text does).
+	int emit_string_copy(string value, string_view comment);
+	// Append LCS 0 'value' for a string made by the compiler. The code generator keeps the text.
+
+	bool is_constant(int address);				// Is the instruction at address LCI, LCR or LCS?
+	int integer_constant(int address);			// Argument of the LCI at address.
+	float real_constant(int address);			// Argument of the LCR at address.
+	string_view string_constant(int address);	// Argument of the LCS at address.
+	void truncate(int address);
+	// Remove the instructions from address on, so that constant loads can be replaced by their folded value.
+
+	int new_label();							// Create a label that has not been placed yet.
+	int emit_jump(op_code op, int label, string_view comment);
+	// Append a JMP or JIF to the label and return its address. The target is filled in when the label is defined.
+	void define_label(int label);				// Place the label at the next address and patch the jumps made to it.
+
+	bool can_inline(int entry, int start, int finish);
+	// Can the statements from start to finish of the routine at entry be copied in place of a call?
+	void emit_inline(int start, int finish, int base, int shift);
+	// Append a copy of the statements from start to finish of a routine, in place of a call. The frame of the routine
+	// is the words from offset base on in the frame of the caller, and the caller is shift static levels further from
+	// each enclosing frame than the routine was. A return jumps past the copy.
+
+	int next_address();							// Address the next instruction will be given.
+	void patch(int address, int arg);			// Set the argument of an instruction emitted earlier, e.g. a frame size.
+	int size();									// Number of instructions emitted.
+
+	int optimize();
+	// Apply the peephole rules until none applies. Returns the number of instructions removed.
+
+	void write(string filename);				// Write the program to the named file as PAL text, with a single write.
+	void write_binary(string filename);			// Write the program to the named file as a binary object, see below.
+	void read_binary(string filename);			// Replace the program with the one held in a binary object.
+
+private:
+	struct instruction {
+		op_code op;
+		int level;
+		int arg;				// Argument of every instruction but LCR and LCS.
+		float real_arg;			// Argument of LCR.
+		string_view text;		// Argument of LCS.
+		string_view comment;	// Explanation written beside the instruction.
+		bool removed {false};	// Deleted by a peephole rule, dropped when the program is compacted.
+	};
+
+	struct label {
+		int address;			// Address of the label, 0 until it is defined.
+		vector<int> jumps;		// Jumps to the label made before it was defined.
+	};
+
+	vector<instruction> code;
+	vector<label> labels;
+	int unresolved;				// Jumps waiting for their label to be defined.
+	string pool;				// String pool of a binary object that has been read. LCS text refers into it.
+	deque<string> made_strings;		// Strings made by the compiler. A deque never moves them, so LCS text can refer to them.
+
+	static constexpr char binary_magic[] = "PALB";
+	static constexpr int binary_version = 1;
+	static constexpr int binary_header_size = 20;
+	static constexpr int binary_instruction_size = 8;
+
+	struct peephole_rule {
+		string_view name;
+		bool (code_gen::*apply)(int i);			// Try the rule on the instruction at index i. True if it changed code.
+	};
+
+	static const peephole_rule peephole_rules[];
+	vector<int> references;		// Jumps and calls to each instruction, counted at the start of each peephole pass.
+
+	void check_labels();
+
+	bool thread_jump(int i);
+	bool return_instead_of_jump(int i);
+	bool remove_jump_to_next(int i);
+	bool remove_unreachable(int i);
+	bool invert_exit_test(int i);
+	bool remove_self_assignment(int i);
+	bool remove_unreachable_routines();
+	void count_references();
+	void compact();
+
+	static string_view mnemonic(op_code op);
+};
+
+#endif /* CODE_GEN_H_ */
@@ -25,6 +25,12 @@
  * Flags are:
  *		-l 				Generate a listing file
  *		-o filename  	Generate code file with the specified name
+ *		-fbinary		Generate the code file as a binary PAL object
+ *		-O				Optimize the generated code
+ *		-finline-for	Compile for loops in line (implied by -O)
+ *		-finline-functions	Compile calls of small routines in line (implied by -O)
+ *		-fdiagnostics-format=json	Report errors as JSON lines (or =text, the default)
+ *		-ferror-limit=n	Stop compiling after n errors (0 for no limit)
  *		-h	Help		Generate help instructions
  *
  **************************************************************************************************/
@@ -43,7 +49,7 @@
 #include "parser.h"
 #include "symbol.h"
 #include "error_handler.h"
-//#include "code_gen.h"
+#include "code_gen.h"
 #include "id_table.h"
 
 using namespace std;
@@ -54,6 +60,12 @@ const string default_source_file_name = "SOURCE";	// Default source code file na
 const string default_code_filename = "CODE";	// Default code file name if one not specified on command line
 
 bool listing_required {false};							// Should a listing file be generated?
+bool binary_code {false};								// Should the code file be a binary PAL object?
+bool optimize_code {false};								// Should the peephole optimizer be run over the code?
+bool inline_for_loops {false};							// Should for loops be compiled in line rather than as routines?
+bool inline_functions {false};							// Should calls of small routines be compiled in line?
+diagnostic_sink::format diagnostics_format {diagnostic_sink::text};	// Format in which errors are reported.
+int error_limit {-1};									// Errors allowed before compilation stops. -1 if not set on the command line.
 
 string source_filename;							// Name of the source file containing DO code to be compiled.
 string code_filename;							// Name of the PAL output file to be generated.
@@ -63,7 +75,7 @@ error_handler* err;								// error handler object
 scanner* scan;
 parser* parse;									// scanner object
 id_table* id_tab = NULL;								// symbol table object
-//code_gen* code;									// code generator
+code_gen* code;									// code generator
 
 bool process_command_line(int argc, char *argv[]) {
 	// Process the command line and identify flags that are set and any filenames provided.
@@ -74,6 +86,12 @@ bool process_command_line(int argc, char *argv[]) {
 	// Flags are:
 	//		-l 				Generate a listing file
 	//		-o filename  	Generate code file with the specified name
+	//		-fbinary		Generate the code file as a binary PAL object
+	//		-O				Optimize the generated code
+	//		-finline-for	Compile for loops in line
+	//		-finline-functions	Compile calls of small routines in line
+	//		-fdiagnostics-format=json|text	Format in which errors are reported
+	//		-ferror-limit=n	Stop compiling after n errors
 	//		-h				Generate help instructions
 
 	bool hflag = false;		// help flag set
@@ -112,6 +130,22 @@ bool process_command_line(int argc, char *argv[]) {
 					cout << "        -o filename     The generated code file (PAL code) is named filename." << endl;
 					cout << "                        If this flag is not present, then the default name of" << endl;
 					cout << "                        of the code file is " << default_code_filename << endl;
+					cout << "        -fbinary        Write the code file as a compact binary PAL object instead of" << endl;
+					cout << "                        PAL text. pal_text converts it back to text." << endl;
+					cout << "        -O              Optimize the generated code: evaluate constant expressions at" << endl;
+					cout << "                        compile time, compile for loops and calls of small routines" << endl;
+					cout << "                        in line and apply a peephole pass." << endl;
+					cout << "        -finline-for    Compile each for loop in the frame of the enclosing block" << endl;
+					cout << "                        instead of as a routine that is called." << endl;
+					cout << "        -finline-functions" << endl;
+					cout << "                        Replace calls of small routines that declare no routines by" << endl;
+					cout << "                        a copy of their statements. pragma INLINE(name) in the" << endl;
+					cout << "                        source asks for a routine to be inlined whatever its size." << endl;
+					cout << "        -fdiagnostics-format=json" << endl;
+					cout << "                        Report errors as JSON lines, one object per error, instead" << endl;
+					cout << "                        of plain text. -fdiagnostics-format=text is the default." << endl;
+					cout << "        -ferror-limit=n Stop compiling as soon as n errors have been found. 0 means" << endl;
+					cout << "                        no limit. pragma ERROR_LIMIT(n) in the source overrides this." << endl;
 				}
 			}
 			else if (arg == "-l")
@@ -120,12 +154,46 @@ bool process_command_line(int argc, char *argv[]) {
 				listing_required = true;	// Set global flag to show that a listing is required.
 				// Name of listing file is based on the name of the source file. It is set up after the command line is processed.
 			}
+			else if (arg == "-O")
+			{
+				optimize_code = true;
+			}
+			else if (arg == "-finline-for")
+			{
+				inline_for_loops = true;
+			}
+			else if (arg == "-finline-functions")
+			{
+				inline_functions = true;
+			}
+			else if (arg == "-fbinary")
+			{
+				binary_code = true;
+			}
+			else if (arg == "-fdiagnostics-format=json")
+			{
+				diagnostics_format = diagnostic_sink::json;
+			}
+			else if (arg == "-fdiagnostics-format=text")
+			{
+				diagnostics_format = diagnostic_sink::text;
+			}
+			else if (arg.rfind("-ferror-limit=", 0) == 0)
+			{
+				string n = arg.substr(string("-ferror-limit=").length());
+				if (n.empty() or (n.find_first_not_of("0123456789") != string::npos) or (n.length() > 9))
+				{
+					cerr << "Illegal error limit: " << arg << endl;
+					return false;
+				}
+				error_limit = stoi(n);
+			}
 			else if (arg == "-o")
 			{
 				// Generate a named output file holding the PAL code.
 				if (i + 1 < argc)			// A file name is expected after the -o flag
 				{
-					code_filename = argv[i++];	// Increment i so we do not get the argument on the next loop iteration.
+					code_filename = argv[++i];	// Increment i so we do not get the argument on the next loop iteration.
 					cflag = true;
 				}
 				else	// No file name provided
@@ -167,7 +235,8 @@ bool process_command_line(int argc, char *argv[]) {
 																					// or the whole name if not present.
 			listing_filename = root_filename + ".lis";		// Append ".lis" to the end of the root filename.
 			if (!cflag)
-				code_filename = root_filename + ".pal";			// Append ".pal" tp the end of the root filename.
+				code_filename = root_filename + (binary_code ? ".palb" : ".pal");	// Append ".pal" tp the end of the root filename,
+																						// or ".palb" for a binary object.
 		}
 		
 		return true;
@@ -199,6 +268,9 @@ bool process_command_line(int argc, char *argv[]) {
 				err = new error_handler(source_filename);
 			else
 				err = new error_handler(source_filename, listing_filename);
+			err->set_diagnostic_format(diagnostics_format);
+			if (error_limit >= 0)
+				err->set_error_limit(error_limit);
 
 			// THE FOLLOWIG CODE IS FOR TESTING PURPOSES ONLY.
                         
@@ -223,19 +295,39 @@ bool process_command_line(int argc, char *argv[]) {
                         } while (tok->get_sym() != symbol::end_of_program);
 			*/
                         // create the code generator
+			code = new code_gen();
 
 			// create a parser object
-			parse = new parser(scan, err, id_tab);
+			parse = new parser(scan, err, id_tab, code);
+			parse->set_constant_folding(optimize_code);
+			parse->set_inline_for_loops(inline_for_loops or optimize_code);
+			parse->set_inline_calls(inline_functions or optimize_code);
                         parse->program();
+			err->flush_diagnostics();			// End of the parsing phase.
 			
                         // Compile the source code
 			
-			// Generate the PAL code file, if no errors were detected.
+			// Optimize and generate the PAL code file, if no errors were detected.
+			if ((err->error_count() == 0) and optimize_code)
+			{
+				int original_size = code->size();
+				int removed = code->optimize();
+				cout << "Peephole optimization removed " << removed << " of " << original_size << " instructions." << endl;
+			}
+			if ((err->error_count() == 0) and binary_code)
+				code->write_binary(code_filename);
+			else if (err->error_count() == 0)
+				code->write(code_filename);
 
 			// Generate a listing, if required.
 			if (listing_required)
 				err->generate_listing();
 
+			// Compilation is complete. Deleting the scanner releases every token in bulk.
+			delete parse;
+			delete code;
+			delete scan;
+
 			stop = high_resolution_clock::now();
 			time_span = duration_cast < milliseconds > (stop - start);
 
@@ -243,11 +335,17 @@ bool process_command_line(int argc, char *argv[]) {
 		}
 		catch (lille_exception &e)
 		{
+			if (err != NULL)
+				err->flush_diagnostics();
 			cerr << "Exception: " << e.what() << endl;
+			if ((err != NULL) and err->error_limit_reached() and listing_required)
+				err->generate_listing();		// List the errors found before compilation stopped.
 			return 1;
 		}
 		catch (exception &e)
 		{
+			if (err != NULL)
+				err->flush_diagnostics();
 			cerr << "Exception: " << e.what() << endl;
 			return 1;
 		}
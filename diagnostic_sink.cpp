@@ -0,0 +1,136 @@
+/*
+ * diagnostic_sink.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: McHale Trotter
+ */
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <cstdio>
+#include <algorithm>
+
+#include "diagnostic_sink.h"
+
+using namespace std;
+
+
+diagnostic_sink::diagnostic_sink(ostream& o) : out(o)
+{
+	fmt = text;
+	source_name = "";
+	flush_threshold = default_flush_threshold;
+	buffer.reserve(flush_threshold + 256);
+}
+
+
+diagnostic_sink::~diagnostic_sink()
+{
+	flush();
+}
+
+
+void diagnostic_sink::set_format(format f)
+{
+	fmt = f;
+}
+
+
+void diagnostic_sink::set_source_name(string name)
+{
+	source_name = name;
+}
+
+
+void diagnostic_sink::set_flush_threshold(size_t bytes)
+{
+	flush_threshold = bytes;
+}
+
+
+void diagnostic_sink::report(int line, int pos, int error_no, string_view message, bool at_token)
+// Add a diagnostic to the buffer, writing the buffer out if it has grown past the threshold.
+{
+	if (fmt == json)
+	{
+		buffer += "{\"file\":";
+		append_json_string(source_name);
+		buffer += ",\"line\":";
+		buffer += to_string(line);
+		buffer += ",\"column\":";
+		buffer += to_string(pos);
+		buffer += ",\"error\":";
+		buffer += to_string(error_no);
+		buffer += ",\"message\":";
+		append_json_string(message);
+		buffer += "}\n";
+	}
+	else
+	{
+		if (at_token)
+		{
+			buffer += "*** ERROR: ";
+			buffer += message;
+			buffer += " Error #";
+			buffer += to_string(error_no);
+			buffer += " at (";
+		}
+		else
+		{
+			buffer += "ERROR: ";
+			buffer += message;
+			buffer += " Error at (";
+		}
+		buffer += to_string(line);
+		buffer += ", ";
+		buffer += to_string(pos);
+		buffer += ").\n";
+	}
+
+	if (buffer.size() >= flush_threshold)
+		flush();
+}
+
+
+void diagnostic_sink::flush()
+// Write everything buffered so far to the stream with a single write.
+{
+	if (!buffer.empty())
+	{
+		out.write(buffer.data(), buffer.size());
+		out.flush();
+		buffer.clear();
+	}
+}
+
+
+void diagnostic_sink::append_json_string(string_view s)
+// Append s as a quoted JSON string, escaping quotes, backslashes and control characters.
+{
+	char escape[8];
+
+	buffer += '"';
+	if (none_of(s.begin(), s.end(), [](char c) { return (c == '"') or (c == '\\') or (static_cast<unsigned char>(c) < 0x20); }))
+	{
+		buffer += s;		// Nothing to escape, which is the usual case.
+		buffer += '"';
+		return;
+	}
+	for (char c : s)
+	{
+		if ((c == '"') or (c == '\\'))
+		{
+			buffer += '\\';
+			buffer += c;
+		}
+		else if (static_cast<unsigned char>(c) < 0x20)
+		{
+			snprintf(escape, sizeof(escape), "\\u%04x", c);
+			buffer += escape;
+		}
+		else
+			buffer += c;
+	}
+	buffer += '"';
+}
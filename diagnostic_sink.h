@@ -0,0 +1,56 @@
+/*
+ * diagnostic_sink.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: McHale Trotter
+ */
+
+#ifndef DIAGNOSTIC_SINK_H_
+#define DIAGNOSTIC_SINK_H_
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+using namespace std;
+
+class diagnostic_sink {
+// Collects the diagnostics reported during compilation and writes them to a stream in batches, rather than one
+// write per diagnostic. Output is flushed when the buffer passes a size threshold, at the end of each phase of
+// compilation, and when the sink is destroyed.
+public:
+	enum format {
+		text,			// *** ERROR: message Error #n at (line, column).
+		json			// One JSON object per line, for tools that collect errors.
+	};
+
+	static const size_t default_flush_threshold = 64 * 1024;	// Bytes buffered before the sink writes them out.
+
+	diagnostic_sink(ostream& o);
+	~diagnostic_sink();
+
+	diagnostic_sink(const diagnostic_sink&) = delete;
+	diagnostic_sink& operator=(const diagnostic_sink&) = delete;
+
+	void set_format(format f);
+	void set_source_name(string name);			// Source file named in JSON output.
+	void set_flush_threshold(size_t bytes);
+
+	void report(int line, int pos, int error_no, string_view message, bool at_token);
+	// Add a diagnostic to the buffer. at_token is true for errors found at a token (by the parser or must_be),
+	// false for errors the scanner found at a character position.
+
+	void flush();								// Write everything buffered so far to the stream.
+
+private:
+	ostream& out;
+	format fmt;
+	string source_name;
+	string buffer;
+	size_t flush_threshold;
+
+	void append_json_string(string_view s);		// Append s as a quoted, escaped JSON string.
+};
+
+#endif /* DIAGNOSTIC_SINK_H_ */
@@ -10,11 +10,18 @@
 #include <fstream>
 #include <filesystem>
 #include <string>
+#include <string_view>
 #include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 
 #include "token.h"
 #include "lille_exception.h"
 #include "error_handler.h"
+#include "source_buffer.h"
+#include "diagnostic_sink.h"
 
 using namespace std;
 
@@ -23,21 +30,18 @@ error_handler::error_handler()
 // Constructor with no source file name or listing file name identified.
 {
 	error_num = 0;
-	err_list = NULL;
 	listing_required = false;
-	initialize_error_messages();
 	error_limit = 10000;
+	limit_reached = false;
 	listing_filename = "";
-	if (filesystem::exists(string(default_source_file_name)))
-	{	// Check file exists
-		source_file.open(default_source_file_name); // Open source file for reading.
-	}
-	else
+	source = nullptr;
+	source_filename = default_source_file_name;
+	diagnostics.set_source_name(this->source_filename);
+	if (!filesystem::exists(string(default_source_file_name)))
 {
 		cerr << "File named \"" + default_source_file_name + "\" does not exist." << endl;
 		throw("File named \"" + default_source_file_name + "\" does not exist.");
 }
-	listing_file.open(default_listing_file_name);
 }
 
 
@@ -45,17 +49,15 @@ error_handler::error_handler(string source_file_name)
 // Constructor. No listing file needed
 {
 	error_num = 0;
-	err_list = NULL;
 	listing_required = false;
-	initialize_error_messages();
 	error_limit = 10000;
+	limit_reached = false;
 	listing_filename = "";
+	source = nullptr;
+	this->source_filename = source_file_name;
+	diagnostics.set_source_name(this->source_filename);
 
-	if (filesystem::exists(source_file_name))
-	{		// Check file exists
-		source_file.open(source_file_name); // Open source file for reading.
-	}
-	else
+	if (!filesystem::exists(source_file_name))		// Check file exists. The scanner reads it.
 		throw("File named \"" + source_file_name + "\" does not exist.");
 	// listing_file.open(default_listing_file_name);
 }
@@ -68,251 +70,361 @@ error_handler::error_handler(string source_file_name, string list_file_name)
 	error_num = 0;
 	listing_required = true;
 	listing_filename = list_file_name;
-	initialize_error_messages();
 	error_limit = 10000;
-	if (filesystem::exists(string(source_file_name)))
-	{		// Check file exists
-		source_file.open(source_file_name); // Open source file for reading.
-	}
-	else
+	limit_reached = false;
+	source = nullptr;
+	this->source_filename = source_file_name;
+	diagnostics.set_source_name(this->source_filename);
+	if (!filesystem::exists(string(source_file_name)))		// Check file exists. The scanner reads it.
 		throw("File named \"" + source_file_name + "\" does not exist.");
 }
 
 
 
-void error_handler::initialize_error_messages()
-// Array of error messages is initialized. This allows the language of the error messages to be changed easily.
+struct error_message_entry {
+	lille_error code;		// Error being described.
+	string_view text;		// Message reported for the error.
+};
+
+
+constexpr error_message_entry error_messages[] = {
+// Text of every error message, in error number order. Keeping the messages in one table allows the language of the
+// error messages to be changed easily.
+	{lille_error::expected_identifier, "Identifier expected."},
+	{lille_error::expected_string, "A string is expected."},
+	{lille_error::expected_real_num, "A real number is expected."},
+	{lille_error::expected_integer, "An integer is expected."},
+	{lille_error::expected_end_of_program, "End of program expected."},
+	{lille_error::expected_semicolon_sym, "A semicolon (;) is expected."},
+	{lille_error::expected_colon_sym, "A colon (:) is expected."},
+	{lille_error::expected_comma_sym, "A comma (,) is expected."},
+	{lille_error::expected_equals_sym, "An equals (=) sign is expected."},
+	{lille_error::expected_not_equals_sym, "A not equals (<>) sign is expected."},
+	{lille_error::expected_less_than_sym, "A less than (<) symbol expected."},
+	{lille_error::expected_greater_than_sym, "A greater than (>) symbol expected."},
+	{lille_error::expected_less_or_equal_sym, "A less then or equal (<=) symbol expected."},
+	{lille_error::expected_greater_or_equal_sym, "A greater than or equal )>=) symbol expected."},
+	{lille_error::expected_plus_sym, "A plus (+) sign is expected."},
+	{lille_error::expected_minus_sym, "A minus (-) sign is expected."},
+	{lille_error::expected_slash_sym, "A slash (/) sign is expected."},
+	{lille_error::expected_asterisk_sym, "An asterisk (*) is expected."},
+	{lille_error::expected_power_sym, "A power (**) sign is expected."},
+	{lille_error::expected_ampersand_sym, "An ampersand (&) is expected."},
+	{lille_error::expected_left_paren_sym, "A left parenthesis (() is expected."},
+	{lille_error::expected_right_paren_sym, "A right parenthesis ()) is expected."},
+	{lille_error::expected_range_sym, "A range symbol (..) is expected."},
+	{lille_error::expected_becomes_sym, "A becomes (:=) symbol is expected."},
+	{lille_error::expected_and_sym, "An AND symbol is expected."},
+	{lille_error::expected_begin_sym, "A BEGIN symbol is expected."},
+	{lille_error::expected_boolean_sym, "A BOOLEAN symbol is expected."},
+	{lille_error::expected_constant_sym, "A CONSTANT symbol is expected."},
+	{lille_error::expected_else_sym, "An ELSE symbol is expected."},
+	{lille_error::expected_elsif_sym, "An ELSIF symbol is expected."},
+	{lille_error::expected_end_sym, "An END symbol is expected."},
+	{lille_error::expected_eof_sym, "An EOF symbol is expected."},
+	{lille_error::expected_exit_sym, "An EXIT symbol is expected."},
+	{lille_error::expected_false_sym, "A FALSE symbol is expected."},
+	{lille_error::expected_for_sym, "A FOR symbol is expected."},
+	{lille_error::expected_function_sym, "A FUNCTION symbol is expected."},
+	{lille_error::expected_if_sym, "An IF symbol is expected."},
+	{lille_error::expected_in_sym, "An IN symbol is expected."},
+	{lille_error::expected_integer_sym, "An INTEGER symbol is expected."},
+	{lille_error::expected_is_sym, "An IS symbol is expected."},
+	{lille_error::expected_loop_sym, "A LOOP symbol is expected."},
+	{lille_error::expected_not_sym, "A NOT symbol is expected."},
+	{lille_error::expected_null_sym, "A NULL symbol is expected."},
+	{lille_error::expected_odd_sym, "An ODD symbol is expected."},
+	{lille_error::expected_or_sym, "An OR symbol is expected."},
+	{lille_error::expected_pragma_sym, "A PRAGMA symbol is expected."},
+	{lille_error::expected_procedure_sym, "A PROCEDURE symbol is expected."},
+	{lille_error::expected_program_sym, "A PROGRAM symbol is expected"},
+	{lille_error::expected_read_sym, "A READ symbol is expected."},
+	{lille_error::expected_real_sym, "A REAL symbol is expected."},
+	{lille_error::expected_ref_sym, "A REF symbol is expected."},
+	{lille_error::expected_return_sym, "A RETURN symbol is expected."},
+	{lille_error::expected_reverse_sym, "A REVVERSE symbol is expected."},
+	{lille_error::expected_string_sym, "A STRING symbol is expected."},
+	{lille_error::expected_then_sym, "A THEN symbol is expected."},
+	{lille_error::expected_true_sym, "A TRUE symbol is expected."},
+	{lille_error::expected_value_sym, "A VALUE symbol is expected."},
+	{lille_error::expected_while_sym, "A WHILE symbol is expected."},
+	{lille_error::expected_write_sym, "A WRITE statement is expected."},
+	{lille_error::expected_writeln_sym, "A WRITELN symbol is expected."},
+	{lille_error::unterminated_string, "String must be terminated before the end of line is encountered."},
+	{lille_error::illegal_underscore, "Illegal underscore in identifier."},
+	{lille_error::number_too_large, "Number too large."},
+	{lille_error::no_digits_after_dot, "Real number must have digits after the dot/period."},
+	{lille_error::no_digits_in_exponent, "Must have digits after exponent symbol."},
+	{lille_error::exponent_too_long, "Too many digits in the exponent."},
+	{lille_error::malformed_real, "Floating point number too large or malformed."},
+	{lille_error::negative_integer_exponent, "An integer can only have a positive exponent."},
+	{lille_error::malformed_integer, "Integer number too large or malformed."},
+	{lille_error::malformed_pragma, "Malformed pragma."},
+	{lille_error::illegal_pragma_name, "Illegal pragma name."},
+	{lille_error::error_limit_needs_number, "Pragma ERROR_LIMIT requires a numeric argument."},
+	{lille_error::variable_name_expected, "Variable name expected."},
+	{lille_error::on_or_off_expected, "ON or OFF expected."},
+	{lille_error::illegal_character, "illegal character."},
+	{lille_error::program_name_mismatch, "Identifier name must match program name."},
+	{lille_error::block_expected, "Block expected."},
+	{lille_error::symbols_after_end_of_program, "End of program expected. No symbols permitted after end of program."},
+	{lille_error::declaration_or_begin_expected, "Declaration or 'begin' expected."},
+	{lille_error::error_in_statement, "Error in statement."},
+	{lille_error::statement_expected, "Statement expected."},
+	{lille_error::undeclared_identifier, "Identifier not previously declared."},
+	{lille_error::duplicate_declaration, "Identifier declared multiple times in same block."},
+	{lille_error::simple_statement_expected, "A simple statement expected."},
+	{lille_error::int_real_or_string_expr_expected, "Integer, real, or string expression expected."},
+	{lille_error::not_assignable, "Identifier is not assignable. Must be a variable or reference parameter."},
+	{lille_error::int_or_real_variable_expected, "Integer or real variable expected."},
+	{lille_error::return_type_mismatch, "Type of expression does not match function return type."},
+	{lille_error::return_outside_routine, "Return statement only valid in a procedure or a function."},
+	{lille_error::exit_outside_loop, "Exit statement is only valid inside a loop."},
+	{lille_error::procedure_name_expected, "Identifier must be a procedure name in this context."},
+	{lille_error::illegal_identifier, "Identifier illegal in this context."},
+	{lille_error::string_or_expr_expected, "String or expression expected."},
+	{lille_error::assignment_type_mismatch, "LHS and RHS of assignment are not type compatible."},
+	{lille_error::param_mode_expected, "Parameter mode expected."},
+	{lille_error::bad_param_list, "Parameter list terminated abnormally."},
+	{lille_error::type_name_expected, "Type name integer, real, string or boolean expected."},
+	{lille_error::param_count_mismatch, "Number of actual and formal parameters does not match."},
+	{lille_error::param_type_mismatch, "Actual and formal parameter types do not match."},
+	{lille_error::param_kind_mismatch, "Actual and formal parameter kinds do not match."},
+	{lille_error::too_many_actual_params, "Too many actual parameters."},
+	{lille_error::compound_statement_expected, "Compound statement expected."},
+	{lille_error::integer_expr_required, "Expression must be of type integer."},
+	{lille_error::boolean_expr_expected, "Boolean expression expected."},
+	{lille_error::integer_range_required, "Ranges of integers only are permitted."},
+	{lille_error::rel_op_expected, "Relational operator expected."},
+	{lille_error::declaration_expected, "Variable, procedure or function declaration expected."},
+	{lille_error::block_name_mismatch, "Identifier must match name of the block."},
+	{lille_error::type_expected, "Type expected."},
+	{lille_error::function_without_return, "Functions must have at least 1 return statement."},
+	{lille_error::constant_value_expected, "Expected value for constant declaration."},
+	{lille_error::constant_type_mismatch, "Constant expression does not match type declaration."},
+	{lille_error::literal_expected, "Literal expected."},
+	{lille_error::illegal_symbol_after_expr, "Illegal symbol follows expression."},
+	{lille_error::expr_types_must_match, "Types of expressions must match."},
+	{lille_error::strings_expected, "Both expressions must be strings."},
+	{lille_error::arithmetic_expr_expected, "Arithmetic expression expected."},
+	{lille_error::boolean_operand_expected, "Boolean expression expected."},
+	{lille_error::numeric_expr_expected, "Integer or real expression expected."},
+	{lille_error::integer_expr_expected, "Integer expression expected."},
+	{lille_error::boolean_condition_expected, "Boolean expression expected."},
+	{lille_error::function_call_expected, "Function call expected."},
+	{lille_error::formal_actual_type_mismatch, "Formal and actual parameter types do not match."},
+	{lille_error::function_ref_param, "Functions can only have value parameters."},
+	{lille_error::invalid_statement_syntax, "Invalid statement syntax"},
+	{lille_error::invalid_compound_statement_syntax, "Invalid compound statement syntax"},
+	{lille_error::invalid_rel_op_syntax, "Invalid relOp syntax"},
+	{lille_error::invalid_primary_syntax, "Invalid primary syntax"},
+	{lille_error::invalid_param_kind_syntax, "Invalid paramKind syntax"},
+	{lille_error::invalid_type_syntax, "Invalid type syntax"},
+	{lille_error::invalid_declaration_syntax, "Invalid declaration syntax"},
+	{lille_error::invalid_expression_syntax, "Invalid expression syntax"},
+	{lille_error::expected_when_sym, "A WHEN symbol is expected."},
+};
+
+
+constexpr bool error_messages_complete()
+// True if the table has exactly one message for each error code, in order, so it can be indexed by error number.
 {
-	error_message[0]  = "Identifier expected.";
-	error_message[1]  = "A string is expected.";
-	error_message[2]  = "A real number is expected.";
-	error_message[3]  = "An integer is expected.";
-	error_message[4]  = "End of program expected.";
-	error_message[5]  = "A semicolon (;) is expected.";
-	error_message[6]  = "A colon (:) is expected.";
-	error_message[7]  = "A comma (,) is expected.";
-	error_message[8]  = "An equals (=) sign is expected.";
-	error_message[9]  = "A not equals (<>) sign is expected.";
-	error_message[10] = "A less than (<) symbol expected.";
-	error_message[11] = "A greater than (>) symbol expected.";
-	error_message[12] = "A less then or equal (<=) symbol expected.";
-	error_message[13] = "A greater than or equal )>=) symbol expected.";
-	error_message[14] = "A plus (+) sign is expected.";
-	error_message[15] = "A minus (-) sign is expected.";
-	error_message[16] = "A slash (/) sign is expected.";
-	error_message[17] = "An asterisk (*) is expected.";
-	error_message[18] = "A power (**) sign is expected.";
-	error_message[19] = "An ampersand (&) is expected.";
-	error_message[20] = "A left parenthesis (() is expected.";
-	error_message[21] = "A right parenthesis ()) is expected.";
-	error_message[22] = "A range symbol (..) is expected.";
-	error_message[23] = "A becomes (:=) symbol is expected.";
-	error_message[24] = "An AND symbol is expected.";
-	error_message[25] = "A BEGIN symbol is expected.";
-	error_message[26] = "A BOOLEAN symbol is expected.";
-	error_message[27] = "A CONSTANT symbol is expected.";
-	error_message[28] = "An ELSE symbol is expected.";
-	error_message[29] = "An ELSIF symbol is expected.";
-	error_message[30] = "An END symbol is expected.";
-	error_message[31] = "An EOF symbol is expected.";
-	error_message[32] = "An EXIT symbol is expected.";
-	error_message[33] = "A FALSE symbol is expected.";
-	error_message[34] = "A FOR symbol is expected.";
-	error_message[35] = "A FUNCTION symbol is expected.";
-	error_message[36] = "An IF symbol is expected.";
-	error_message[37] = "An IN symbol is expected.";
-	error_message[38] = "An INTEGER symbol is expected.";
-	error_message[39] = "An IS symbol is expected.";
-	error_message[40] = "A LOOP symbol is expected.";
-	error_message[41] = "A NOT symbol is expected.";
-	error_message[42] = "A NULL symbol is expected.";
-	error_message[43] = "An ODD symbol is expected.";
-	error_message[44] = "An OR symbol is expected.";
-	error_message[45] = "A PRAGMA symbol is expected.";
-	error_message[46] = "A PROCEDURE symbol is expected.";
-	error_message[47] = "A PROGRAM symbol is expected";
-	error_message[48] = "A READ symbol is expected.";
-	error_message[49] = "A REAL symbol is expected.";
-	error_message[50] = "A REF symbol is expected.";
-	error_message[51] = "A RETURN symbol is expected.";
-	error_message[52] = "A REVVERSE symbol is expected.";
-	error_message[53] = "A STRING symbol is expected.";
-	error_message[54] = "A THEN symbol is expected.";
-	error_message[55] = "A TRUE symbol is expected.";
-	error_message[56] = "A VALUE symbol is expected.";
-	error_message[57] = "A WHILE symbol is expected.";
-	error_message[58] = "A WRITE statement is expected.";
-	error_message[59] = "A WRITELN symbol is expected.";
-	error_message[60] = "String must be terminated before the end of line is encountered.";
-	error_message[61] = "Illegal underscore in identifier.";
-	error_message[62] = "Number too large.";
-	error_message[63] = "Real number must have digits after the dot/period.";
-	error_message[64] = "Must have digits after exponent symbol.";
-	error_message[65] = "Too many digits in the exponent.";
-	error_message[66] = "Floating point number too large or malformed.";
-	error_message[67] = "An integer can only have a positive exponent.";
-	error_message[68] = "Integer number too large or malformed.";
-	error_message[69] = "Malformed pragma.";
-	error_message[70] = "Illegal pragma name.";
-	error_message[71] = "Pragma ERROR_LIMIT requires a numeric argument.";
-	error_message[72] = "Variable name expected.";
-	error_message[73] = "ON or OFF expected.";
-	error_message[74] = "illegal character.";
-	error_message[75] = "Identifier name must match program name.";
-	error_message[76] = "Block expected.";
-	error_message[77] = "End of program expected. No symbols permitted after end of program.";
-	error_message[78] = "Declaration or 'begin' expected.";
-	error_message[79] = "Error in statement.";
-	error_message[80] = "Statement expected.";
-	error_message[81] = "Identifier not previously declared.";
-	error_message[82] = "Identifier declared multiple times in same block.";
-	error_message[83] = "A simple statement expected.";
-	error_message[84] = "Integer, real, or string expression expected.";
-	error_message[85] = "Identifier is not assignable. Must be a variable or reference parameter.";
-	error_message[86] = "Integer or real variable expected.";
-	error_message[87] = "Type of expression does not match function return type.";
-	error_message[88] = "Return statement only valid in a procedure or a function.";
-	error_message[89] = "Exit statement is only valid inside a loop.";
-	error_message[90] = "Identifier must be a procedure name in this context.";
-	error_message[91] = "Identifier illegal in this context.";
-	error_message[92] = "String or expression expected.";
-	error_message[93] = "LHS and RHS of assignment are not type compatible.";
-	error_message[94] = "Parameter mode expected.";
-	error_message[95] = "Parameter list terminated abnormally.";
-	error_message[96] = "Type name integer, real, string or boolean expected.";
-	error_message[97] = "Number of actual and formal parameters does not match.";
-	error_message[98] = "Actual and formal parameter types do not match.";
-	error_message[99] = "Actual and formal parameter kinds do not match.";
-	error_message[100] = "Too many actual parameters.";
-	error_message[101] = "Compound statement expected.";
-	error_message[102] = "Expression must be of type integer.";
-	error_message[103] = "Boolean expression expected.";
-	error_message[104] = "Ranges of integers only are permitted.";
-	error_message[105] = "Relational operator expected.";
-	error_message[106] = "Variable, procedure or function declaration expected.";
-	error_message[107] = "Identifier must match name of the block.";
-	error_message[108] = "Type expected.";
-	error_message[109] = "Functions must have at least 1 return statement.";
-	error_message[110] = "Expected value for constant declaration.";
-	error_message[111] = "Constant expression does not match type declaration.";
-	error_message[112] = "Literal expected.";
-	error_message[113] = "Illegal symbol follows expression.";
-	error_message[114] = "Types of expressions must match.";
-	error_message[115] = "Both expressions must be strings.";
-	error_message[116] = "Arithmetic expression expected.";
-	error_message[117] = "Boolean expression expected.";
-	error_message[118] = "Integer or real expression expected.";
-	error_message[119] = "Integer expression expected.";
-	error_message[120] = "Boolean expression expected.";
-	error_message[121] = "Function call expected.";
-	error_message[122] = "Formal and actual parameter types do not match.";
-	error_message[123] = "Functions can only have value parameters.";
-        error_message[124] = "Invalid statement syntax";
-        error_message[125] = "Invalid compound statement syntax";
-        error_message[126] = "Invalid relOp syntax";
-        error_message[126] = "Invalid expression syntax";
-        error_message[127] = "Invalid primary syntax";
-        error_message[128] = "Invalid paramKind syntax";
-        error_message[129] = "Invalid type syntax";
-        error_message[130] = "Invalid declaration syntax";
+	if (size(error_messages) != size_t(lille_error::number_of_error_codes))
+		return false;
+	for (size_t i = 0; i < size(error_messages); i++)
+		if ((error_messages[i].code != lille_error(i)) or error_messages[i].text.empty())
+			return false;
+	return true;
 }
 
+static_assert(error_messages_complete(), "Each error code needs exactly one message, listed in error number order.");
 
-void error_handler::add_error_to_list(int line, int pos, int err)
-// Add error details to list so it can be added to listing file later.
+
+string_view error_handler::message(lille_error error_no)
+// Text of the given error.
 {
-	error_list* next_err = new error_list;
-	next_err->line_no = line;
-	next_err->pos_no = pos;
-	next_err->err_no = err;
-	next_err->next = NULL;
-
-	error_list* temp1;
-	error_list* temp2;
-
-	if (err_list == NULL)
-		err_list = next_err;
-	else
-	{
-		// check if new error is to become the head of the error_list
-		if ((err_list->line_no >= next_err->line_no) and (err_list->pos_no > next_err->pos_no))
-		{
-			// insert at head of list
-			next_err->next = err_list;
-			err_list = next_err;
-		}
-		else
-		{
-			// insert the next_err into its correct place in the list
-			temp1 = err_list;
-			temp2 = temp1->next;
-			while ((temp2 != NULL) and (temp2->line_no < next_err->line_no))
-			{
-				temp1 = temp1->next;
-				temp2 = temp2->next;
-			}
-			// either at the end of the list, or there are multiple errors on this line
-			while ((temp2 != NULL) and (temp2->pos_no <= next_err->pos_no))
+	if ((error_no < lille_error(0)) or (error_no >= lille_error::number_of_error_codes))
+		throw lille_exception("Unknown error code " + to_string(int(error_no)) + ".");
+	return error_messages[int(error_no)].text;
+}
+
+
+void error_handler::add_error_to_list(int line, int pos, lille_error err)
+// Add error details to list so it can be added to listing file later. Errors are simply appended; they are put in
+// order once, by sort_error_list(), when the listing is generated.
+{
+	err_list.push_back(error_entry{line, pos, err});
+}
+
+
+void error_handler::sort_error_list()
+// Sort the errors by line number and then position on the line. The sort is stable, so errors flagged at the same
+// position keep the order in which they were found. Then record where the errors for each line begin.
+{
+	stable_sort(err_list.begin(), err_list.end(),
+			[](const error_entry& a, const error_entry& b)
 			{
-				temp1 = temp1->next;
-				temp2 = temp2->next;
-			}
-			// now at the insertion point
-			next_err->next = temp2;
-			temp1->next = next_err;
-		}
-	}
+				return (a.line_no < b.line_no) or ((a.line_no == b.line_no) and (a.pos_no < b.pos_no));
+			});
+
+	int last_line = err_list.empty() ? 0 : max(err_list.back().line_no, 0);
+	first_error_on_line.assign(last_line + 2, 0);
+	for (const error_entry& e : err_list)
+		first_error_on_line[max(e.line_no, 0) + 1]++;
+	for (int l = 1; l < int(first_error_on_line.size()); l++)
+		first_error_on_line[l] += first_error_on_line[l - 1];
 }
 
-void error_handler::flag(int line_number, int pos_on_line, int error_no)
+void error_handler::flag(int line_number, int pos_on_line, lille_error error_no)
 // Error detected by scanner at specified position.
 {
-        error_num++;
-	if (error_num <= error_limit)
-	{
-		cerr << "ERROR: " << error_message[error_no] << " Error at (" << line_number << ", " << pos_on_line << ")." << endl;
-		add_error_to_list(line_number, pos_on_line, error_no);
-	}
+	error_num++;
+	diagnostics.report(line_number, pos_on_line, int(error_no), message(error_no), false);
+	add_error_to_list(line_number, pos_on_line, error_no);
+	check_error_limit();
 }
 
 
-void error_handler::flag(token* tok, int error_no)
+void error_handler::flag(token* tok, lille_error error_no)
 // Error detected at token tok.
 {
 	// Generate an error message and retain the token and message in an appropriate data structure
 	// so that a listing file can be generated at the completion of the compilation.
 	error_num++;
-        if (error_num <= error_limit)
+	diagnostics.report(tok->get_line_number(), tok->get_pos_on_line(), int(error_no), message(error_no), true);
+	add_error_to_list(tok->get_line_number(), tok->get_pos_on_line(), error_no);
+	check_error_limit();
+}
+
+
+void error_handler::check_error_limit()
+// Once the error limit is reached there is no point in compiling any further. The exception unwinds the scanner and
+// parser back to the compiler's main program.
+{
+	if ((error_limit > 0) and (error_num >= error_limit))
 	{
-		cerr << "*** ERROR: " << error_message[error_no] << " Error #"  << error_no << " at (" << tok->get_line_number() << ", " << tok->get_pos_on_line() << ")." << endl;
-              add_error_to_list(tok->get_line_number(), tok->get_pos_on_line(), error_no);
+		limit_reached = true;
+		diagnostics.flush();
+		throw lille_exception("Error limit of " + to_string(error_limit) + " reached. Compilation stopped.");
 	}
 }
 
 
 void error_handler::set_error_limit(int i)
+// Stop compiling after i errors. 0 means no limit. If i errors have already been found, compilation stops now.
+{
+	error_limit = max(i, 0);
+	check_error_limit();
+}
+
+
+bool error_handler::error_limit_reached()
 {
-	error_limit = i;
+	return limit_reached;
+}
+
+
+void error_handler::set_diagnostic_format(diagnostic_sink::format f)
+{
+	diagnostics.set_format(f);
+}
+
+
+void error_handler::flush_diagnostics()
+// Write out the errors reported so far. Called at the end of each phase of compilation.
+{
+	diagnostics.flush();
+}
+
+
+void error_handler::set_source(source_buffer* src)
+// The scanner shares the source text it has loaded so the listing does not read the file a second time.
+{
+	source = src;
+}
+
+
+void error_handler::list_errors(string& out, int line)
+// Append the errors flagged on the given line to the listing. Each error is a caret under the offending column
+// followed by the message.
+{
+	const int no_width = 4;
+	const int space = 1;
+
+	if (line >= int(first_error_on_line.size()) - 1)
+		return;		// No errors on this line or any later line.
+
+	for (int e = first_error_on_line[line]; e < first_error_on_line[line + 1]; e++)
+	{
+		const error_entry& err = err_list[e];
+		out.append(no_width + space + max(err.pos_no, 0), ' ');
+		out += "^\n*** ERROR #";
+		out += to_string(int(err.err_no));
+		out += ": ";
+		out += message(err.err_no);
+		out += '\n';
+	}
 }
 
 
 void error_handler::generate_listing()
-// generate a listing file.
+// Generate a listing file. The source text and the sorted errors are merged in a single pass into one buffer, which
+// is written to the listing file with a single write.
 {
-	error_list* error_this_line;
-	int line_number {1};
-	int err_count = 0;
-	string source_line;
 	const int no_width = 4;
 	const int space = 1;
-	bool enter_loop {false};
+	source_buffer own_source;			// Only used if the scanner has not shared its copy of the source.
+	string out;
+	char line_no[16];
 
 	if (listing_required)
 	{
-		// GENERATE THE LISTING FILE.
+		sort_error_list();
+
+		if (source == nullptr)
+		{
+			own_source.load(source_filename);
+			source = &own_source;
+		}
+
+		// Room for the source, a line number on each line and roughly one line of text per error.
+		out.reserve(source->size() + (source->size() / 8) + (err_list.size() * 80) + 64);
+
+		int line_number {1};
+		const char* next_line = source->begin();
+		while (next_line < source->end())
+		{
+			const char* newline = static_cast<const char*>(memchr(next_line, '\n', source->end() - next_line));
+			const char* line_end = (newline == nullptr) ? source->end() : newline;
+
+			int n = snprintf(line_no, sizeof(line_no), "%*d", no_width, line_number);
+			out.append(line_no, n);
+			out.append(space, ' ');
+			out.append(next_line, line_end);
+			out += '\n';
+			list_errors(out, line_number);
+
+			next_line = (newline == nullptr) ? source->end() : newline + 1;
+			line_number++;
+		}
+
+		// Errors reported at the end of the file, past the last line of source (or on no line at all).
+		list_errors(out, 0);
+		for (int l = line_number; l < int(first_error_on_line.size()) - 1; l++)
+			list_errors(out, l);
+
+		out += '\n';
+		out += to_string(error_num);
+		out += (error_num == 1) ? " error found.\n" : " errors found.\n";
+
+		if (source == &own_source)
+			source = nullptr;
 
-		// INSERT CODE HERE.
-		
+		listing_file.open(listing_filename, ios::out | ios::binary);
+		if (!listing_file)
+			throw lille_exception("Unable to create listing file \"" + listing_filename + "\".");
+		listing_file.write(out.data(), out.size());
+		listing_file.close();
 	}
 	// else do nothing since no listing file name was provided.
 }
@@ -12,46 +12,198 @@
 #include <fstream>
 #include <filesystem>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "token.h"
 #include "lille_exception.h"
+#include "source_buffer.h"
+#include "diagnostic_sink.h"
 
 using namespace std;
 
+enum class lille_error : int {	// Every error the compiler can report. The value is the error number shown to the user.
+	none = -1,						// No error. Used for symbols that have no "expected" message.
+	expected_identifier = 0,
+	expected_string,
+	expected_real_num,
+	expected_integer,
+	expected_end_of_program,
+	expected_semicolon_sym,
+	expected_colon_sym,
+	expected_comma_sym,
+	expected_equals_sym,
+	expected_not_equals_sym,
+	expected_less_than_sym,
+	expected_greater_than_sym,
+	expected_less_or_equal_sym,
+	expected_greater_or_equal_sym,
+	expected_plus_sym,
+	expected_minus_sym,
+	expected_slash_sym,
+	expected_asterisk_sym,
+	expected_power_sym,
+	expected_ampersand_sym,
+	expected_left_paren_sym,
+	expected_right_paren_sym,
+	expected_range_sym,
+	expected_becomes_sym,
+	expected_and_sym,
+	expected_begin_sym,
+	expected_boolean_sym,
+	expected_constant_sym,
+	expected_else_sym,
+	expected_elsif_sym,
+	expected_end_sym,
+	expected_eof_sym,
+	expected_exit_sym,
+	expected_false_sym,
+	expected_for_sym,
+	expected_function_sym,
+	expected_if_sym,
+	expected_in_sym,
+	expected_integer_sym,
+	expected_is_sym,
+	expected_loop_sym,
+	expected_not_sym,
+	expected_null_sym,
+	expected_odd_sym,
+	expected_or_sym,
+	expected_pragma_sym,
+	expected_procedure_sym,
+	expected_program_sym,
+	expected_read_sym,
+	expected_real_sym,
+	expected_ref_sym,
+	expected_return_sym,
+	expected_reverse_sym,
+	expected_string_sym,
+	expected_then_sym,
+	expected_true_sym,
+	expected_value_sym,
+	expected_while_sym,
+	expected_write_sym,
+	expected_writeln_sym,
+	unterminated_string,
+	illegal_underscore,
+	number_too_large,
+	no_digits_after_dot,
+	no_digits_in_exponent,
+	exponent_too_long,
+	malformed_real,
+	negative_integer_exponent,
+	malformed_integer,
+	malformed_pragma,
+	illegal_pragma_name,
+	error_limit_needs_number,
+	variable_name_expected,
+	on_or_off_expected,
+	illegal_character,
+	program_name_mismatch,
+	block_expected,
+	symbols_after_end_of_program,
+	declaration_or_begin_expected,
+	error_in_statement,
+	statement_expected,
+	undeclared_identifier,
+	duplicate_declaration,
+	simple_statement_expected,
+	int_real_or_string_expr_expected,
+	not_assignable,
+	int_or_real_variable_expected,
+	return_type_mismatch,
+	return_outside_routine,
+	exit_outside_loop,
+	procedure_name_expected,
+	illegal_identifier,
+	string_or_expr_expected,
+	assignment_type_mismatch,
+	param_mode_expected,
+	bad_param_list,
+	type_name_expected,
+	param_count_mismatch,
+	param_type_mismatch,
+	param_kind_mismatch,
+	too_many_actual_params,
+	compound_statement_expected,
+	integer_expr_required,
+	boolean_expr_expected,
+	integer_range_required,
+	rel_op_expected,
+	declaration_expected,
+	block_name_mismatch,
+	type_expected,
+	function_without_return,
+	constant_value_expected,
+	constant_type_mismatch,
+	literal_expected,
+	illegal_symbol_after_expr,
+	expr_types_must_match,
+	strings_expected,
+	arithmetic_expr_expected,
+	boolean_operand_expected,
+	numeric_expr_expected,
+	integer_expr_expected,
+	boolean_condition_expected,
+	function_call_expected,
+	formal_actual_type_mismatch,
+	function_ref_param,
+	invalid_statement_syntax,
+	invalid_compound_statement_syntax,
+	invalid_rel_op_syntax,
+	invalid_primary_syntax,
+	invalid_param_kind_syntax,
+	invalid_type_syntax,
+	invalid_declaration_syntax,
+	invalid_expression_syntax,
+	expected_when_sym,
+	number_of_error_codes			// Not an error. Must be last.
+};
+
+
 class error_handler {
 private:
 	error_handler();									// Construct. No source file listed. Use cin.
 	string listing_filename;
 	string default_listing_file_name = "LISTING";
 	string default_source_file_name = "SOURCE";
+	string source_filename;
 	bool listing_required;
-	ifstream source_file;
+	source_buffer* source;				// Source text already loaded by the scanner, if any. Used for the listing.
 	ofstream listing_file;
+	diagnostic_sink diagnostics {cerr};	// Errors are reported through this as they are flagged.
 	int error_num;
-	int error_limit;
+	int error_limit;					// Compilation stops once this many errors are found. 0 means no limit.
+	bool limit_reached;					// True once compilation has been stopped by the error limit.
 
-	struct error_list {
+	struct error_entry {
 		int line_no;
 		int pos_no;
-		int err_no;
-		error_list* next;
+		lille_error err_no;
 	};
 
-	error_list* err_list;
-	
+	vector<error_entry> err_list;			// Errors in the order they were flagged, until sort_error_list() is called.
+	vector<int> first_error_on_line;		// After sort_error_list(): index in err_list of the first error on each line.
+											// The errors on line l are err_list[first_error_on_line[l]] up to (but not
+											// including) err_list[first_error_on_line[l + 1]].
 
-	static const int max_error_message_index = 150;		// There are 100 error messages that can be generated by the compiler.
-	string error_message[max_error_message_index];		// Array with error message
-	void initialize_error_messages();					// set up the array of error messages
-	void add_error_to_list(int line, int pos, int err);
+	void add_error_to_list(int line, int pos, lille_error err);
+	void check_error_limit();							// Stop compilation if the error limit has been reached.
+	void sort_error_list();								// Order errors by line and position and bucket them by line.
+	void list_errors(string& out, int line);			// Append the errors flagged on the given line to the listing.
 
 public:		
 	error_handler(string source_file_name);								// Constructor. No listing file needed
 	error_handler(string source_file_name, string list_file_name);		// Constructor. Specifies name of listing file
 
-	void flag(int line_number, int pos_on_line, int error_no);			// Error detected by scanner at specified position.
-	void flag(token* tok, int error_no);								// Error detected at token tok.
-	void set_error_limit(int i);
+	void flag(int line_number, int pos_on_line, lille_error error_no);			// Error detected by scanner at specified position.
+	void flag(token* tok, lille_error error_no);									// Error detected at token tok.
+	void set_error_limit(int i);										// Stop compiling after i errors. 0 means no limit.
+	bool error_limit_reached();											// Was compilation stopped by the error limit?
+	static string_view message(lille_error error_no);					// Text of the given error.
+	void set_diagnostic_format(diagnostic_sink::format f);				// Report errors as plain text or JSON lines.
+	void flush_diagnostics();											// Write out errors reported so far. Call at the end of each phase.
+	void set_source(source_buffer* src);								// Source text to list, shared with the scanner.
 	void generate_listing();											// Generate a listing file.
 	int error_count();													// Number of errors found so far.
 };
@@ -9,6 +9,9 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <new>
+#include <algorithm>
 
 #include "token.h"
 #include "error_handler.h"
@@ -16,6 +19,7 @@
 #include "id_table_entry.h"
 #include "lille_kind.h"
 #include "lille_type.h"
+#include "atom_table.h"
 
 
 using namespace std;
@@ -26,26 +30,44 @@ id_table::id_table(error_handler* err)
    error = err;
    debug_mode = false;
    scope_level = 0;
+   scope_start.push_back(0);
+   regions.emplace_back();
+   slots_used = 0;      // No slots are allocated until the first entry is added.
+}
 
-   for(int i = 0; i < max_depth; i++)
-   {
-      sym_table[i] = new node;
-      sym_table[i]->idt = NULL;
-      sym_table[i]->left = NULL;
-      sym_table[i]->right = NULL;
-   }
+//Destructor releases the entries of every scope that is still open
+id_table::~id_table()
+{
+   for(region& r : regions)
+      release(r);
+   release(unscoped);
 }
 
 //Increment the scope level when entering a new scope
 void id_table::enter_scope()
 {
    scope_level++;
-   //sym_table[scope_level] = nullptr;
+   scope_start.push_back(bindings.size());
+   regions.emplace_back();
 }
 
-//Decrement the scope level when exiting a scope
+//Decrement the scope level when exiting a scope. Every entry made in the scope is removed, uncovering any entry of
+//the same name in an enclosing scope, in time proportional to the number of entries made in the scope. The storage of
+//the entries is then released in one operation.
 void id_table::exit_scope()
 {
+   if(scope_level < 0)
+      return;
+
+   while(int(bindings.size()) > scope_start.back())
+   {
+      binding& b = bindings.back();
+      slots[find_slot(b.atom)].visible = b.shadowed;
+      bindings.pop_back();
+   }
+   scope_start.pop_back();
+   release(regions.back());
+   regions.pop_back();
    scope_level--;
 }
 
@@ -55,78 +77,110 @@ int id_table::scope()
    return scope_level;
 }
 
-//Look up an identifier in the symbol table based on its name
-id_table_entry* id_table::lookup(string s)
+//Region holding the entries of the given scope
+id_table::region& id_table::region_of(int scope)
 {
-   int scope = scope_level;
-   node* ptr = sym_table[scope];
-   bool found = false;
+   if(scope < 0 or scope >= int(regions.size()))
+      return unscoped;
+   else
+      return regions[scope];
+}
 
-   while(scope >= 0)
+//Bump allocate an entry in region r
+id_table_entry* id_table::new_entry(region& r, token* id, lille_type typ, lille_kind kind, int level, int offset, lille_type return_tipe)
+{
+   if(r.used == region_block_size)
    {
-      if(ptr == NULL or ptr->idt == NULL)
-      {
-         if(scope > 0)
-            ptr = sym_table[--scope];
-         else
-            scope--;
-      }
-      else if(s < ptr->idt->name())
-      {
-         ptr = ptr->left;
-      }
-      else if(s > ptr->idt->name())
-      {
-         ptr = ptr->right;
-      }
-      else if(s == ptr->idt->name())
-      {
-         if(debug_mode == true)
-            cout << "ENTRY FOUND: found entry " << s << " of type " << ptr->idt->tipe().to_string() << endl;
-            return ptr->idt;
-      }
+      r.blocks.push_back(static_cast<id_table_entry*>(::operator new(region_block_size * sizeof(id_table_entry))));
+      r.used = 0;
    }
-   if(debug_mode == true)
-      cout << "DID NOT FIND: Didn't find entry " << s << endl;
-   return NULL;
+   id_table_entry* entry = new (r.blocks.back() + r.used) id_table_entry(id, typ, kind, level, offset, return_tipe);
+   r.used++;
+   return entry;
 }
 
-//Look up an identifier in the symbol table based on a token
-id_table_entry* id_table::lookup(token* tok)
+//Destroy every entry in region r and free its blocks
+void id_table::release(region& r)
 {
-   int scope = scope_level;
-   node* ptr = sym_table[scope];
-   bool found = false;
+   for(size_t b = 0; b < r.blocks.size(); b++)
+   {
+      int count = (b + 1 == r.blocks.size()) ? r.used : region_block_size;
+      for(int i = 0; i < count; i++)
+         r.blocks[b][i].~id_table_entry();
+      ::operator delete(r.blocks[b]);
+   }
+   r.blocks.clear();
+   r.used = region_block_size;
+}
 
-   while(scope >= 0)
+//Find the slot owned by atom, or the empty slot where atom would be placed. Linear probing from a Fibonacci hash.
+int id_table::find_slot(int atom)
+{
+   unsigned int mask = slots.size() - 1;
+   unsigned int i = (unsigned int)(atom * 2654435769u) & mask;
+
+   while(slots[i].atom != atom and slots[i].atom != empty_slot)
+      i = (i + 1) & mask;
+   return i;
+}
+
+//Double the number of slots, starting from 64. Only atoms that are visible at the moment need a slot.
+void id_table::grow()
+{
+   vector<slot> old_slots = move(slots);
+
+   slots.assign(old_slots.empty() ? 64 : old_slots.size() * 2, slot{empty_slot, -1});
+   slots_used = 0;
+   for(slot& s : old_slots)
    {
-      if(ptr == NULL or ptr->idt == NULL)
-      {
-         if(scope > 0)
-            ptr = sym_table[--scope];
-         else
-            scope--;
-      }
-      else if(tok < ptr->idt->token_value())
+      if(s.atom != empty_slot and s.visible != -1)
       {
-         ptr = ptr->left;
-      }
-      else if(tok > ptr->idt->token_value())
-      {
-         ptr = ptr->right;
-      }
-      else if(tok == ptr->idt->token_value())
-      {
-         if(debug_mode == true)
-            cout << "ENTRY FOUND: found entry " << tok->to_string() << " of type " << endl;
-            return ptr->idt;
+         slots[find_slot(s.atom)] = s;
+         slots_used++;
       }
    }
+}
+
+//Look up an identifier in the symbol table based on its name
+id_table_entry* id_table::lookup(string s)
+{
+   int atom = atom_table::find(s);
+
+   if(atom == atom_table::no_atom)
+   {
+      if(debug_mode == true)
+         cout << "DID NOT FIND: Didn't find entry " << s << endl;
+      return NULL;
+   }
+   return lookup(atom);
+}
+
+//Look up an identifier in the symbol table based on the atom of its name
+id_table_entry* id_table::lookup(int atom)
+{
+   int visible = -1;
+
+   if(atom != atom_table::no_atom and !slots.empty())
+      visible = slots[find_slot(atom)].visible;
+
+   if(visible != -1)
+   {
+      if(debug_mode == true)
+         cout << "ENTRY FOUND: found entry " << bindings[visible].idt->name() << " of type " << bindings[visible].idt->tipe().to_string() << endl;
+      return bindings[visible].idt;
+   }
    if(debug_mode == true)
-      cout << "DID NOT FIND: Didn't find entry " << tok->to_string() << endl;
+      cout << "DID NOT FIND: Didn't find entry " << (atom == atom_table::no_atom ? "" : atom_table::name(atom)) << endl;
    return NULL;
 }
 
+//Look up an identifier in the symbol table based on a token. The atom recorded in the token when it was scanned is
+//the key, so no string is built or compared and any token naming the identifier finds its entry.
+id_table_entry* id_table::lookup(token* tok)
+{
+   return lookup(tok->get_identifier_atom());
+}
+
 //Enable or disable tracing of all entries for debugging purposes
 void id_table::trace_all(bool b)
 {
@@ -144,66 +198,81 @@ bool id_table::trace_all()
 //Add an entry to the symbol table
 void id_table::add_table_entry(id_table_entry* id)
 {
+   int atom = id->atom();
 
-	node* entry = new node;
-	entry->idt = id;
-	entry->right = NULL;
-	entry->left = NULL;
+   if(slots.empty())
+      grow();
 
-	node* node1 = sym_table[scope()], * node2 = NULL;
+   int s = find_slot(atom);
 
-	bool found = false;
-	while(node1->idt != NULL)
-	{
-		node2 = node1;
-		if(id->name() < node1->idt->name())
-		{
-			node1 = node1->left;
-		}
-		else
-		{
-			node1 = node1->right;
-		}
-		if(node1 == NULL)
-			break;
-	}
+   if(slots[s].atom == empty_slot)
+   {
+      if(2 * (slots_used + 1) > int(slots.size()))
+      {
+         grow();
+         s = find_slot(atom);
+      }
+      slots[s].atom = atom;
+      slots[s].visible = -1;
+      slots_used++;
+   }
 
-	if(node2 == NULL)  
-		sym_table[scope()] = entry;
-	else if (id->name() < node2->idt->name()) 
-        node2->left = entry;
-	else
-		node2->right = entry;
+   bindings.push_back(binding{id, atom, slots[s].visible});
+   slots[s].visible = bindings.size() - 1;
 
-	if(debug_mode)
-		cout << "ADDED ENTRY: Created Entry " << id->name() << " in Scope " << scope() << endl;
+   if(debug_mode)
+      cout << "ADDED ENTRY: Created Entry " << id->name() << " in Scope " << scope() << endl;
 
 }
 
 //Enter a new identifier into the symbol table with specified attributes
 id_table_entry* id_table::enter_id(token* id, lille_type typ, lille_kind kind, int level, int offset, lille_type return_tipe)
 {
-   id_table_entry* id_entry = new id_table_entry(id, typ, kind, level, offset, return_tipe);
-   add_table_entry(id_entry/*, sym_table[scope_level]*/);
+   id_table_entry* id_entry = new_entry(region_of(scope_level), id, typ, kind, level, offset, return_tipe);
+   add_table_entry(id_entry);
+   if((typ.is_type(lille_type::type_proc) || typ.is_type(lille_type::type_func)) &&
+      find(inline_names.begin(), inline_names.end(), id->get_identifier_atom()) != inline_names.end())
+      id_entry->request_inline();
    return id_entry;
 }
 
+//Ask for a routine to be compiled in line, now or when it is declared
+void id_table::request_inline(int atom)
+{
+   id_table_entry* routine = lookup(atom);
+
+   if(routine != NULL && (routine->tipe().is_type(lille_type::type_proc) || routine->tipe().is_type(lille_type::type_func)))
+      routine->request_inline();
+   else if(find(inline_names.begin(), inline_names.end(), atom) == inline_names.end())
+      inline_names.push_back(atom);
+}
+
+//Create a parameter of routine, allocated in the scope in which the routine is declared
+id_table_entry* id_table::enter_param(id_table_entry* routine, token* id, lille_type typ, lille_kind kind, int level, int offset)
+{
+   int routine_scope = min(routine->level(), scope_level);
+   id_table_entry* param_entry = new_entry(region_of(routine_scope), id, typ, kind, level, offset, lille_type::type_unknown);
+
+   routine->add_param(param_entry);
+   if(scope_level > routine_scope)
+      add_table_entry(param_entry);
+   return param_entry;
+}
+
 //Dump the entire symbol table for debugging purposes
 void id_table::dump_id_table(bool dump_all)
 {
-   	node* ptr;
 	if (!dump_all)
 	{
 		if(debug_mode)
 		{
 			cout << "Dump of idtable for current scope only." << endl;
 			cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << endl;
+			for(int b = scope_start.empty() ? 0 : scope_start.back(); b < int(bindings.size()); b++)
+				cout << bindings[b].idt->to_string() << endl;
 		}
 
-		ptr = sym_table[scope()];
 		exit_scope();
-		delete ptr;
-		ptr = NULL;
 	}
 	else
 	{
@@ -211,137 +280,18 @@ void id_table::dump_id_table(bool dump_all)
 		{
 			cout << "Dump of the entire symbol table." << endl;
 			cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << endl;
+			for(binding& b : bindings)
+				cout << b.idt->to_string() << endl;
 		}
 		
         	while(scope() > 0)
-        	{
-			ptr = sym_table[scope()];
 			exit_scope();
-			delete ptr;
-			ptr = NULL;
-		}
 	}
 }
 
-//Recursive function to search for an identifier in the binary search tree
-id_table::node* id_table::search_tree(string s, node* p)
-{
-   if (!p)
-   {
-      return nullptr;
-   }
-
-   if (s == p->idt->name())
-   {
-      return p;
-   }
-
-   if (s < p->idt->name())
-   {
-      return search_tree(s, p->right);
-   }
-
-   return search_tree(s, p->right);
-}
-
-void id_table::add_table_entry(id_table_entry* it, id_table::node* ptr)
-{
-   bool inserted = false;
-   if(ptr != NULL)
-   {
-      string tab_name = it->token_value()->get_identifier_value();
-      string temp;
-      while(!inserted)
-      {
-         temp = ptr->idt->token_value()->get_identifier_value();
-         if(tab_name == temp)
-         {
-            error->flag(it->token_value(), 82); //identifier declared multiple times
-            break;
-         }
-         else if (tab_name < temp)
-         {
-            //insert left
-            if (ptr->left == NULL)
-            {
-               node* n = new node;
-               n->left = NULL;
-               n->right = NULL;
-               n->idt = it;
-               ptr->left = n;
-               inserted = true;
-            }
-            else
-               ptr = ptr->left;
-         }
-         else
-         {
-            //insert right
-            if (ptr->right == NULL)
-            {
-               node* n = new node;
-               n->left = NULL;
-               n->right = NULL;
-               n->idt = it;
-               ptr->right = n;
-               inserted = true;
-            }
-            else
-               ptr = ptr->right;
-         }
-      }
-   }
-}
-
-
-
-
-//Recursive function to dump the binary search tree in-order
-void id_table::dump_tree(node* ptr)
-{
-   if (ptr)
-   {
-      dump_tree(ptr->left);
-      cout << ptr->idt->to_string() << endl;
-      dump_tree(ptr->right);
-   }
-}
-
-//Recursive function to dump additional information about identifiers in the binary search tree
-void id_table::dump_all_ident(node* ptr)
+//Dump the name and type of every identifier that is currently declared
+void id_table::dump_all_ident()
 {
-   if(ptr)
-   {
-      dump_all_ident(ptr->left);
-      cout << "Identifier: " << ptr->idt->name() << "   Type: " << ptr->idt->tipe().to_string() << endl;
-      dump_all_ident(ptr->right);
-   }
-
+   for(binding& b : bindings)
+      cout << "Identifier: " << b.idt->name() << "   Type: " << b.idt->tipe().to_string() << endl;
 }
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
@@ -10,6 +10,7 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "token.h"
 #include "error_handler.h"
@@ -27,38 +28,80 @@ private:
    bool debug_mode;
    int scope_level;
 
-   static const int max_depth = 1000; // maximum depth of nesting permitted in source code
-   struct node {
-   node* left;
-   node* right;
+   // Every declaration is recorded as a binding, in the order the declarations are made. The bindings of the
+   // innermost scope are therefore always at the end of the vector, which makes it the undo log for exit_scope().
+   struct binding {
    id_table_entry* idt;
+   int atom;            // atom of the name of the entry
+   int shadowed;        // binding of the same name in an enclosing scope that this one hides, or -1
    };
+   vector<binding> bindings;
+   vector<int> scope_start;      // index in bindings of the first binding of each open scope. Grows with the nesting.
+
+   // Open addressing hash table from atom to the innermost visible binding of that atom (or -1 if the atom is not
+   // visible at the moment). Slots are never emptied once claimed by an atom, so no tombstones are needed.
+   struct slot {
+   int atom;            // atom that owns this slot, or empty_slot
+   int visible;         // index in bindings, or -1
+   };
+   static const int empty_slot = -2;  // distinct from every atom, including atom_table::no_atom
+   vector<slot> slots;                // capacity is 0 until the first entry is added, then always a power of 2
+   int slots_used;
+
+   // Storage for the entries made in one scope. Entries are bump allocated in blocks and are all destroyed together
+   // when the scope is closed.
+   static const int region_block_size = 64;   // entries per block
+   struct region {
+   vector<id_table_entry*> blocks;   // every block but the last is full
+   int used {region_block_size};     // entries constructed in the last block
+   };
+   vector<region> regions;            // one for each open scope, parallel to scope_start
+   region unscoped;                   // entries made while no scope is open. Released with the table.
+
+   region& region_of(int scope);      // region of an open scope, or unscoped
+   id_table_entry* new_entry(region& r, token* id, lille_type typ, lille_kind kind, int level, int offset, lille_type return_tipe);
+   void release(region& r);           // destroy every entry in r and free its blocks
 
-   node* sym_table[max_depth];
-   node* search_tree(string s, node* p);
-   void add_table_entry(id_table_entry* it, node* ptr);
-   void dump_tree(node* ptr);
+   vector<int> inline_names;          // atoms named by pragma INLINE while no routine of that name was visible
+
+   int find_slot(int atom);           // slot owned by atom, or the empty slot where it would go
+   void grow();                       // double the number of slots (or create the first ones) and re-insert the visible bindings
 
 public:
    id_table(error_handler* err);
+   ~id_table();
+   id_table(const id_table&) = delete;
+   id_table& operator=(const id_table&) = delete;
     
    void enter_scope();
    void exit_scope();
    int scope();
 
    id_table_entry* lookup(string s);
+   id_table_entry* lookup(int atom);
    id_table_entry* lookup(token* tok);
    void trace_all(bool b);
    bool trace_all();
 
+   void request_inline(int atom);
+   // Pragma INLINE. Asks for calls of the visible routine with the name to be compiled in line. If no routine of that
+   // name is visible yet, the request is kept and applies to every routine of that name declared later.
+
    void add_table_entry(id_table_entry* it);
 
 
    id_table_entry* enter_id(token* id, lille_type typ = lille_type::type_unknown, lille_kind kind = lille_kind::unknown, int level = 0, int offset = 0, lille_type return_tipe = lille_type::type_unknown);
+   // Creates an entry in the current scope and binds its name there. The entry is destroyed when the scope is exited.
+
+   id_table_entry* enter_param(id_table_entry* routine, token* id, lille_type typ, lille_kind kind, int level = 0, int offset = 0);
+   // Creates a parameter and appends it to the parameter list of routine. The signature of a routine is needed at every
+   // call, long after the scope of the routine has closed, so the parameter is promoted: it is allocated with the routine,
+   // in the scope in which the routine is declared. Its name is bound in the current scope if that is nested inside the
+   // routine's scope (i.e. the routine's own scope, where its body can refer to the parameter).
 
    void dump_id_table(bool dump_all = true);
 
-   void dump_all_ident(node* ptr);
+   void dump_all_ident();
 
 
 
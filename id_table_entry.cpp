@@ -2,6 +2,8 @@
 #include "token.h"
 #include "lille_type.h"
 #include "lille_kind.h"
+#include "atom_table.h"
+#include "lille_exception.h"
 
 using namespace std;
 
@@ -15,26 +17,26 @@ id_table_entry::id_table_entry()
     kind_entry = lille_kind();
     trace_entry = false;
     typ_entry = lille_type();
-    i_val_entry = 0;
-    r_val_entry = 0.0;
-    s_val_entry = "";
-    b_val_entry = false;
-    p_list_entry = nullptr;
-    n_par_entry = 0;
-    r_ty_entry = lille_type();
 }
 
 //Parameterized constructor initializes member variables with provided values
 id_table_entry::id_table_entry(token* id, lille_type typ, lille_kind kind, int level, int offset, lille_type return_tipe)
-    : id_entry(id), typ_entry(typ), kind_entry(kind), lev_entry(level), offset_entry(offset), r_ty_entry(return_tipe)
+    : id_entry(id), lev_entry(level), offset_entry(offset), kind_entry(kind), typ_entry(typ)
 {
     trace_entry = false;
-    i_val_entry = 0;
-    r_val_entry = 0.0;
-    s_val_entry = "";
-    b_val_entry = false;
-    p_list_entry = nullptr;
-    n_par_entry = 0;
+    if (!return_tipe.is_type(lille_type::type_unknown))
+        routine()->r_ty_entry = return_tipe;
+}
+
+//Get the routine details of the entry, creating them the first time they are needed
+id_table_entry::routine_info* id_table_entry::routine()
+{
+    if (!routine_entry)
+    {
+        routine_entry = make_unique<routine_info>();
+        routine_entry->r_ty_entry = lille_type::type_unknown;
+    }
+    return routine_entry.get();
 }
 
 //Enable or disable tracing for this entry
@@ -82,92 +84,149 @@ token* id_table_entry::token_value()
 //Get the name of the entry
 string id_table_entry::name()
 {
-    return id_entry ? id_entry->get_identifier_value() : "";
+    return id_entry ? string(id_entry->get_identifier_value()) : "";
+}
+
+//Get the atom of the entry's name, used to compare names as integers
+int id_table_entry::atom()
+{
+    return id_entry ? id_entry->get_identifier_atom() : atom_table::no_atom;
 }
 
 //Get the integer value of the entry
 int id_table_entry::integer_value()
 {
-    return i_val_entry;
+    return holds_alternative<int>(const_entry) ? get<int>(const_entry) : 0;
 }
 
 //Get the real value of the entry
 float id_table_entry::real_value()
 {
-    return r_val_entry;
+    return holds_alternative<float>(const_entry) ? get<float>(const_entry) : 0.0;
 }
 
 //Get the string value of the entry
-string id_table_entry::string_value()
+string_view id_table_entry::string_value()
 {
-    return s_val_entry;
+    return holds_alternative<string_view>(const_entry) ? get<string_view>(const_entry) : string_view();
 }
 
 //Get the boolean value of the entry
 bool id_table_entry::bool_value()
 {
-    return b_val_entry;
+    return holds_alternative<bool>(const_entry) ? get<bool>(const_entry) : false;
 }
 
 //Get the return type for the entry
 lille_type id_table_entry::return_tipe()
 {
-    return r_ty_entry;
+    return routine_entry ? routine_entry->r_ty_entry : lille_type(lille_type::type_unknown);
+}
+
+//Set the constant value for the entry. Only the value matching the type of the constant is kept.
+void id_table_entry::fix_const(int integer_value, float real_value, string_view string_value, bool bool_value)
+{
+    if (!kind_entry.is_kind(lille_kind::constant))
+        throw lille_exception("Attempt to fix the value of an identifier that is not a constant.");
+
+    if (typ_entry.is_type(lille_type::type_integer))
+        const_entry = integer_value;
+    else if (typ_entry.is_type(lille_type::type_real))
+        const_entry = real_value;
+    else if (typ_entry.is_type(lille_type::type_string))
+        const_entry = string_value;
+    else if (typ_entry.is_type(lille_type::type_boolean))
+        const_entry = bool_value;
+    else
+        const_entry = monostate();
+}
+
+//Get the address of the first PAL instruction of a procedure or function
+int id_table_entry::code_address()
+{
+    return routine_entry ? routine_entry->code_addr_entry : 0;
 }
 
-//Set constant values for the entry
-void id_table_entry::fix_const(int integer_value, float real_value, string string_value, bool bool_value)
+int id_table_entry::body_start()
 {
-    i_val_entry = integer_value;
-    r_val_entry = real_value;
-    s_val_entry = string_value;
-    b_val_entry = bool_value;
+    return routine_entry ? routine_entry->body_start_entry : 0;
+}
+
+int id_table_entry::body_finish()
+{
+    return routine_entry ? routine_entry->body_finish_entry : 0;
+}
+
+int id_table_entry::frame_size()
+{
+    return routine_entry ? routine_entry->frame_entry : 0;
+}
+
+bool id_table_entry::inline_requested()
+{
+    return routine_entry ? routine_entry->inline_entry : false;
 }
 
 //Set the return type for the entry
 void id_table_entry::fix_return_type(lille_type ret_ty)
 {
-    r_ty_entry = ret_ty;
+    routine()->r_ty_entry = ret_ty;
 }
 
-//Add a parameter to the entry's parameter list
+//Set the address of the first PAL instruction of a procedure or function
+void id_table_entry::fix_code_address(int addr)
+{
+    routine()->code_addr_entry = addr;
+}
+
+//Record the first and last instructions of the statements of the routine and the size of its frame
+void id_table_entry::fix_body(int start, int finish, int frame)
+{
+    routine()->body_start_entry = start;
+    routine()->body_finish_entry = finish;
+    routine()->frame_entry = frame;
+}
+
+//Ask for the calls of the routine to be compiled in line
+void id_table_entry::request_inline()
+{
+    routine()->inline_entry = true;
+}
+
+//Add a parameter to the end of the entry's parameter list. The first few parameters are held in the entry itself;
+//after that they all move to p_list_entry. Either way they are contiguous.
 void id_table_entry::add_param(id_table_entry* param_entry)
 {
-    if (!p_list_entry)
+    routine_info* r = routine();
+
+    if (r->n_par_entry < routine_info::inline_params)
     {
-        p_list_entry = param_entry;
-    } 
+        r->p_inline_entry[r->n_par_entry] = param_entry;
+    }
     else
     {
-        id_table_entry* temp = p_list_entry;
-        while (temp->p_list_entry)
-        {
-            temp = temp->p_list_entry;
-        }
-        temp->p_list_entry = param_entry;
+        if (r->n_par_entry == routine_info::inline_params)
+            r->p_list_entry.assign(r->p_inline_entry, r->p_inline_entry + routine_info::inline_params);
+        r->p_list_entry.push_back(param_entry);
     }
-    n_par_entry++;
+    r->n_par_entry++;
 }
 
-//Get the nth parameter from the entry's parameter list
+//Get the nth parameter (counting from 1) from the entry's parameter list in constant time
 id_table_entry* id_table_entry::nth_parameter(int n)
 {
-    id_table_entry* temp = p_list_entry;
-    for (int i = 1; i < n; ++i)
-    {
-        if (!temp)
-        {
-            return nullptr;
-        }
-        temp = temp->p_list_entry;
-    }
-    return temp;
+    if (n < 1 or n > number_of_params())
+        return nullptr;
+    else if (routine_entry->n_par_entry <= routine_info::inline_params)
+        return routine_entry->p_inline_entry[n - 1];
+    else
+        return routine_entry->p_list_entry[n - 1];
 }
 
 //Get the number of parameters in the entry's parameter list
 int id_table_entry::number_of_params()
 {
-    return n_par_entry;
+    return routine_entry ? routine_entry->n_par_entry : 0;
 }
 
 //Convert the entry to a string for debugging purposes
@@ -1,5 +1,9 @@
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <variant>
+#include <memory>
 
 #include "token.h"
 #include "lille_type.h"
@@ -13,19 +17,35 @@ using namespace std;
 
 class id_table_entry {
 private:
+   // Details that only procedures and functions have. Kept apart from the entry so that the far more common
+   // variables and constants do not carry them.
+   struct routine_info {
+      static const int inline_params = 4;               // parameters held here before p_list_entry is used
+      id_table_entry* p_inline_entry[inline_params];    // parameters, while there are no more than inline_params of them
+      vector<id_table_entry*> p_list_entry;             // all of the parameters, once there are more than inline_params
+      int n_par_entry {0};
+      lille_type r_ty_entry;
+      int code_addr_entry {0};                          // address of the first PAL instruction of the routine
+      int body_start_entry {0};                         // first and last instructions of the statements of a routine
+      int body_finish_entry {0};                        // that can be compiled in line, 0 if it cannot
+      int frame_entry {0};                              // words in the frame of the routine
+      bool inline_entry {false};                        // pragma INLINE has been given for the routine
+   };
+
+   // Value of a constant. Holds monostate for anything that is not a constant. String constants view the text of
+   // their token, which lives as long as the entry.
+   using constant_value = variant<monostate, int, float, bool, string_view>;
+
    token* id_entry;
+   constant_value const_entry;
+   unique_ptr<routine_info> routine_entry;              // Only present for procedures and functions.
    int lev_entry;
    int offset_entry;
    lille_kind kind_entry;
-   bool trace_entry;
    lille_type typ_entry;
-   int i_val_entry;
-   float r_val_entry;
-   string s_val_entry;
-   bool b_val_entry;
-   id_table_entry* p_list_entry;
-   int n_par_entry;
-   lille_type r_ty_entry;
+   bool trace_entry;
+
+   routine_info* routine();                             // Routine details, created when first needed.
 
 public:
    id_table_entry();
@@ -39,14 +59,26 @@ public:
    lille_type tipe();
    token* token_value();
    string name();
+   int atom();
    int integer_value();
    float real_value();
-   string string_value();
+   string_view string_value();
    bool bool_value();
    lille_type return_tipe();
+   int code_address();
+   int body_start();
+   int body_finish();
+   int frame_size();
+   bool inline_requested();
 
-   void fix_const(int integer_value = 0, float real_value = 0, string string_value = "", bool bool_value = false);
+   void fix_const(int integer_value = 0, float real_value = 0, string_view string_value = "", bool bool_value = false);
+   // Record the value of a constant. Only the argument matching the type of the entry is kept.
+   // Raises a lille_exception if the entry is not a constant.
    void fix_return_type(lille_type ret_ty);
+   void fix_code_address(int addr);
+   void fix_body(int start, int finish, int frame);
+   // Record where the statements of a routine without nested routines are, so calls can be compiled in line.
+   void request_inline();
    void add_param(id_table_entry* param_entry);
    id_table_entry* nth_parameter(int n);
    int number_of_params();
@@ -0,0 +1,61 @@
+ /*************************************************************************************************
+ *
+ * PAL object to text converter
+ *
+ * Author:     McHale Trotter
+ *
+ * Written:            16 October 2026
+ *
+ * Open Source - free to distribute and modify. May not be used for profit.
+ *
+ * Converts a binary PAL object, written by the lille compiler with the -fbinary flag, back into
+ * the PAL text format so that tools that read PAL text keep working.
+ *
+ * Usage
+ *        pal_text object_filename [text_filename]
+ * If text_filename is not given, the text is written to the root of object_filename with ".pal"
+ * appended.
+ *
+ **************************************************************************************************/
+
+
+#include <iostream>
+#include <string>
+
+#include "lille_exception.h"
+#include "code_gen.h"
+
+using namespace std;
+
+
+int main(int argc, char *argv[])
+{
+	string object_filename;
+	string text_filename;
+
+	if ((argc < 2) or (argc > 3))
+	{
+		cerr << "Usage: " << argv[0] << " object_filename [text_filename]" << endl;
+		return 1;
+	}
+	object_filename = argv[1];
+	if (argc == 3)
+		text_filename = argv[2];
+	else
+		text_filename = object_filename.substr(0, object_filename.find(".")) + ".pal";
+
+	try
+	{
+		code_gen code;
+
+		code.read_binary(object_filename);
+		code.write(text_filename);
+		cout << code.size() << " instructions written to " << text_filename << "." << endl;
+	}
+	catch (lille_exception &e)
+	{
+		cerr << "Exception: " << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
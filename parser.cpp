@@ -5,6 +5,8 @@
 #include <cctype>
 #include <cmath>
 #include <vector>
+#include <algorithm>
+#include <limits>
 #include "symbol.h"
 #include "scanner.h"
 #include "error_handler.h"
@@ -13,44 +15,488 @@
 #include "lille_exception.h"
 #include "id_table.h"
 #include "id_table_entry.h"
+#include "code_gen.h"
 
 // Constructor for the parser class, initializing member variables.
-parser::parser(scanner* scan, error_handler* err, id_table* id_tab)
+parser::parser(scanner* scan, error_handler* err, id_table* id_tab, code_gen* code)
 {
    this->scan = scan;
-   this->error = error;
+   this->error = err;
    this->id_tab = id_tab;
+   this->code = code;
 
    curr_entry = NULL;
    curr_ident = NULL;
    curr_func_proc = NULL;
 
+   next_offset = 0;
+   frame_size = 0;
 }
 
-// Define a function in the symbol table with its name, return type, and argument type.
-void parser::define_function(string name, lille_type x, lille_type y)
+void parser::set_constant_folding(bool on)
+{
+   folding = on;
+}
+
+void parser::set_inline_for_loops(bool on)
+{
+   inline_for = on;
+}
+
+void parser::set_inline_calls(bool on)
+{
+   inline_calls = on;
+}
+
+// Number of static levels between the scope being compiled and the scope in which entry was declared.
+int parser::level_diff(id_table_entry* entry)
+{
+   int diff = id_tab->scope() - entry->level();
+
+   // The scope of an inline for loop has no frame of its own, so it is not a static level.
+   for(int level : inline_scopes)
+      if(level > entry->level() && level <= id_tab->scope())
+         diff--;
+   return diff;
+}
+
+// Reserve a word in the frame of the block being compiled to hold a temporary value.
+int parser::new_temp()
+{
+   int temp = next_offset++;
+   frame_size = max(frame_size, next_offset);
+   return temp;
+}
+
+// Release the temporary reserved last by new_temp().
+void parser::release_temp()
+{
+   next_offset--;
+}
+
+// Reserve space for the variables declared in a block, after its parameters.
+void parser::reserve_locals(int params)
+{
+   if(next_offset > params)
+      code->emit(code_gen::INC, 0, next_offset - params, "Reserve space for declared variables and constants.");
+}
+
+// Can the current token start an expression?
+bool parser::starts_expr()
+{
+   return scan->have(symbol::identifier) || scan->have(symbol::integer) || scan->have(symbol::real_num) ||
+          scan->have(symbol::strng) || scan->have(symbol::true_sym) || scan->have(symbol::false_sym) ||
+          scan->have(symbol::not_sym) || scan->have(symbol::odd_sym) || scan->have(symbol::left_paren_sym) ||
+          scan->have(symbol::plus_sym) || scan->have(symbol::minus_sym);
+}
+
+// Compile a return inside a for loop compiled as a routine. Returning from the loop routine alone would carry on with
+// the enclosing routine, so the loop routine sets a return flag in the frame of the enclosing routine, keeping any
+// function value beside it, and each loop call tests the flag when it finishes.
+void parser::return_from_loop()
+{
+   int depth = loop_frames.size();
+
+   // The flag and the value take two words of the routine frame, reserved by the first such return.
+   if(loop_return < 0)
+   {
+      auto& [offset, size] = loop_frames.front();
+      loop_return = offset;
+      offset += 2;
+      size = max(size, offset);
+   }
+   if(curr_func_proc->tipe().is_type(lille_type::type_func))
+      code->emit(code_gen::STO, depth, loop_return + 1, "Keep the function value until the for loops are left.");
+   code->emit(code_gen::LCI, 0, 1, "Load boolean value.");
+   code->emit(code_gen::STO, depth, loop_return, "Set the return flag of the routine.");
+   code->emit_opr(code_gen::procedure_return, "Return from for loop.");
+   loop_returns++;
+}
+
+// Start compiling a loop. Exit statements from here on leave this loop.
+void parser::open_loop()
+{
+   exit_labels.push_back(code->new_label());
+}
+
+// Finish compiling the innermost loop. Every exit from it jumps to the next instruction.
+void parser::close_loop()
+{
+   code->define_label(exit_labels.back());
+   exit_labels.pop_back();
+}
+
+// Push the value of a variable, parameter or constant onto the stack.
+lille_type parser::load(id_table_entry* entry)
+{
+   lille_kind kind = entry->kind();
+
+   if(kind.is_kind(lille_kind::constant))
+   {
+      if(entry->tipe().is_type(lille_type::type_real))
+         code->emit_real(entry->real_value(), "Load real value.");
+      else if(entry->tipe().is_type(lille_type::type_string))
+         code->emit_string(entry->string_value(), "Load string value.");
+      else if(entry->tipe().is_type(lille_type::type_boolean))
+         code->emit(code_gen::LCI, 0, entry->bool_value() ? 1 : 0, "Load boolean value.");
+      else
+         code->emit(code_gen::LCI, 0, entry->integer_value(), "Load integer value.");
+   }
+   else if(kind.is_kind(lille_kind::ref_param))
+   {
+      code->emit(code_gen::LDV, level_diff(entry), entry->offset(), "Load address held by reference parameter.");
+      code->emit(code_gen::LDI, 0, 0, "Load value of reference parameter.");
+   }
+   else if(kind.is_kind(lille_kind::value_param))
+      code->emit(code_gen::LDV, level_diff(entry), entry->offset(), "Load value parameter.");
+   else if(kind.is_kind(lille_kind::for_ident))
+      code->emit(code_gen::LDV, level_diff(entry), entry->offset(), "Load For loop parameter.");
+   else
+      code->emit(code_gen::LDV, level_diff(entry), entry->offset(), "Load variable or constant.");
+
+   return entry->tipe();
+}
+
+// Pop the top of the stack into a variable or reference parameter.
+void parser::store(id_table_entry* entry, token* tok)
+{
+   lille_kind kind = entry->kind();
+
+   if(kind.is_kind(lille_kind::variable))
+      code->emit(code_gen::STO, level_diff(entry), entry->offset(), "Store result.");
+   else if(kind.is_kind(lille_kind::ref_param))
+   {
+      code->emit(code_gen::LDV, level_diff(entry), entry->offset(), "Load address of variable to store the result.");
+      code->emit(code_gen::STI, 0, 0, "Store expression.");
+   }
+   else
+      error->flag(tok, lille_error::not_assignable);   // Identifier is not assignable.
+}
+
+// Call a procedure or function: mark the stack, push the actual parameters (if any) and call the routine.
+lille_type parser::call(id_table_entry* routine)
+{
+   int n = 0;
+   token* tok = scan->this_token();
+   bool is_function = routine->tipe().is_type(lille_type::type_func);
+   bool in_line = inlinable(routine);
+   int start = code->next_address();
+
+   if(!in_line)
+      code->emit(code_gen::MST, level_diff(routine), 0, "Mark stack.");
+   int args = code->next_address();
+   if(scan->have(symbol::left_paren_sym))
+   {
+      scan->must_be(symbol::left_paren_sym);
+      argument(routine, ++n);
+      while(scan->have(symbol::comma_sym))
+      {
+         scan->must_be(symbol::comma_sym);
+         argument(routine, ++n);
+      }
+      scan->must_be(symbol::right_paren_sym);
+   }
+   if(n != routine->number_of_params())
+      error->flag(tok, lille_error::param_count_mismatch);   // Number of actual and formal parameters does not match.
+
+   if(fold_call(start, args, routine))
+      return lille_type::type_string;
+   else if(in_line && n == routine->number_of_params())
+      inline_call(routine);
+   else
+      code->emit(code_gen::CAL, routine->number_of_params(), routine->code_address(), is_function ? "Function call." : "Call the procedure.");
+
+   return is_function ? routine->return_tipe() : lille_type(lille_type::type_unknown);
+}
+
+// Can a call of the routine be replaced by a copy of its statements? Only when inlining is enabled, the statements are
+// known and, unless pragma INLINE asked for the routine to be compiled in line, no longer than inline_threshold
+// instructions.
+bool parser::inlinable(id_table_entry* routine)
+{
+   int start = routine->body_start();
+   int finish = routine->body_finish();
+
+   if(!inline_calls || start == 0 || (!routine->inline_requested() && finish - start + 1 > inline_threshold))
+      return false;
+   return code->can_inline(routine->code_address(), start, finish);
+}
+
+// Compile a call in line. The actual parameters on the stack are stored in words of the current frame that stand in
+// for the frame of the routine, and its statements are copied to work on them. A value parameter holds a copy of its
+// actual parameter and a reference parameter its address, just as in the frame of a call, so both keep their meaning.
+void parser::inline_call(id_table_entry* routine)
+{
+   int base = next_offset;
+   for(int i = 0; i < routine->frame_size(); i++)
+      new_temp();
+   for(int i = routine->number_of_params(); i >= 1; i--)
+      code->emit(code_gen::STO, 0, base + i - 1, "Store actual parameter of inlined routine.");
+   code->emit_inline(routine->body_start(), routine->body_finish(), base, level_diff(routine) - 1);
+   for(int i = 0; i < routine->frame_size(); i++)
+      release_temp();
+}
+
+// Compile the nth actual parameter of a call. A reference parameter is passed the address of a variable.
+void parser::argument(id_table_entry* routine, int n)
+{
+   id_table_entry* formal = (n <= routine->number_of_params()) ? routine->nth_parameter(n) : NULL;
+
+   if(formal != NULL && formal->kind().is_kind(lille_kind::ref_param))
+   {
+      token* tok = scan->this_token();
+      id_table_entry* actual = scan->have(symbol::identifier) ? id_tab->lookup(tok) : NULL;
+
+      if(actual != NULL && actual->kind().is_kind(lille_kind::variable))
+      {
+         scan->must_be(symbol::identifier);
+         code->emit(code_gen::LDA, level_diff(actual), actual->offset(), "Load actual reference parameter");
+      }
+      else if(actual != NULL && actual->kind().is_kind(lille_kind::ref_param))
+      {
+         scan->must_be(symbol::identifier);
+         code->emit(code_gen::LDV, level_diff(actual), actual->offset(), "Load actual reference parameter");
+      }
+      else
+      {
+         error->flag(tok, lille_error::param_kind_mismatch);   // Actual and formal parameter kinds do not match.
+         expr();
+      }
+   }
+   else
+      expr();
+}
+
+// Replace the constant operands of an operation, loaded from address on, by the constant result.
+static void load_integer(code_gen* code, int address, long long value)
+{
+   code->truncate(address);
+   code->emit(code_gen::LCI, 0, int(value), "Load integer value.");
+}
+
+static void load_boolean(code_gen* code, int address, bool value)
+{
+   code->truncate(address);
+   code->emit(code_gen::LCI, 0, value ? 1 : 0, "Load boolean value.");
+}
+
+// Is an integer result within the range of lille integers? Results that overflow are left to run time.
+static bool integer_fits(long long value)
+{
+   return value >= numeric_limits<int>::min() && value <= numeric_limits<int>::max();
+}
+
+// Is a real result held exactly by a lille real? Results that would be rounded are left to run time.
+static bool real_fits(double value)
+{
+   return isfinite(value) && double(float(value)) == value;
+}
+
+// Evaluate a binary operation at compile time when both of its operands are constants. The left operand is loaded
+// by the instruction at address left and the right operand by the instruction after it, the last one emitted. The
+// two loads are replaced by a load of the result and ty becomes its type.
+bool parser::fold(int left, lille_type& ty, lille_type right_ty, code_gen::opr_code op)
+{
+   if(!folding || code->next_address() != left + 2 || !code->is_constant(left) || !code->is_constant(left + 1) ||
+      ty.get_type() != right_ty.get_type())
+      return false;
+
+   if(ty.is_type(lille_type::type_integer))
+   {
+      long long a = code->integer_constant(left);
+      long long b = code->integer_constant(left + 1);
+      long long r = 0;
+
+      switch(op)
+      {
+         case code_gen::add:           r = a + b; break;
+         case code_gen::subtract:      r = a - b; break;
+         case code_gen::multiply:      r = a * b; break;
+         case code_gen::divide:
+            if(a < 0 || b <= 0)        // Leave division by zero, and the rounding of negative quotients, to run time.
+               return false;
+            r = a / b;
+            break;
+         case code_gen::power:
+            if(b < 0)
+               return false;
+            // Powers of 0, 1 and -1 never overflow, so they are not worked out by repeated multiplication.
+            if(a == 0 || a == 1)
+               r = (b == 0) ? 1 : a;
+            else if(a == -1)
+               r = (b % 2 == 0) ? 1 : -1;
+            else
+            {
+               r = 1;
+               for(long long i = 0; i < b && integer_fits(r); i++)
+                  r *= a;
+            }
+            break;
+         case code_gen::equal:            load_boolean(code, left, a == b); ty = lille_type::type_boolean; return true;
+         case code_gen::not_equal:        load_boolean(code, left, a != b); ty = lille_type::type_boolean; return true;
+         case code_gen::less_than:        load_boolean(code, left, a < b);  ty = lille_type::type_boolean; return true;
+         case code_gen::less_or_equal:    load_boolean(code, left, a <= b); ty = lille_type::type_boolean; return true;
+         case code_gen::greater_than:     load_boolean(code, left, a > b);  ty = lille_type::type_boolean; return true;
+         case code_gen::greater_or_equal: load_boolean(code, left, a >= b); ty = lille_type::type_boolean; return true;
+         default:
+            return false;
+      }
+      if(!integer_fits(r))
+         return false;
+      load_integer(code, left, r);
+      return true;
+   }
+   else if(ty.is_type(lille_type::type_real))
+   {
+      double a = code->real_constant(left);
+      double b = code->real_constant(left + 1);
+      double r = 0.0;
+
+      switch(op)
+      {
+         case code_gen::add:           r = a + b; break;
+         case code_gen::subtract:      r = a - b; break;
+         case code_gen::multiply:      r = a * b; break;
+         case code_gen::divide:
+            if(b == 0.0)
+               return false;
+            r = a / b;
+            break;
+         case code_gen::equal:            load_boolean(code, left, a == b); ty = lille_type::type_boolean; return true;
+         case code_gen::not_equal:        load_boolean(code, left, a != b); ty = lille_type::type_boolean; return true;
+         case code_gen::less_than:        load_boolean(code, left, a < b);  ty = lille_type::type_boolean; return true;
+         case code_gen::less_or_equal:    load_boolean(code, left, a <= b); ty = lille_type::type_boolean; return true;
+         case code_gen::greater_than:     load_boolean(code, left, a > b);  ty = lille_type::type_boolean; return true;
+         case code_gen::greater_or_equal: load_boolean(code, left, a >= b); ty = lille_type::type_boolean; return true;
+         default:
+            return false;
+      }
+      if(!real_fits(r))
+         return false;
+      code->truncate(left);
+      code->emit_real(float(r), "Load real value.");
+      return true;
+   }
+   else if(ty.is_type(lille_type::type_string))
+   {
+      string_view a = code->string_constant(left);
+      string_view b = code->string_constant(left + 1);
+
+      if(op == code_gen::concatenate)
+      {
+         string r = string(a) + string(b);
+         code->truncate(left);
+         code->emit_string_copy(move(r), "Load string value.");
+         return true;
+      }
+      else if(op == code_gen::equal || op == code_gen::not_equal)
+      {
+         load_boolean(code, left, (a == b) == (op == code_gen::equal));
+         ty = lille_type::type_boolean;
+         return true;
+      }
+   }
+   else if(ty.is_type(lille_type::type_boolean))
+   {
+      bool a = code->integer_constant(left) != 0;
+      bool b = code->integer_constant(left + 1) != 0;
+
+      switch(op)
+      {
+         case code_gen::logical_and:   load_boolean(code, left, a && b); return true;
+         case code_gen::logical_or:    load_boolean(code, left, a || b); return true;
+         case code_gen::equal:         load_boolean(code, left, a == b); return true;
+         case code_gen::not_equal:     load_boolean(code, left, a != b); return true;
+         default:
+            return false;
+      }
+   }
+   return false;
+}
+
+// Evaluate a unary operation at compile time when its operand, loaded by the last instruction emitted, is a constant.
+bool parser::fold(int operand, lille_type& ty, code_gen::opr_code op)
+{
+   if(!folding || code->next_address() != operand + 1 || !code->is_constant(operand))
+      return false;
+
+   if(op == code_gen::negate && ty.is_type(lille_type::type_integer))
+   {
+      long long r = -(long long)code->integer_constant(operand);
+      if(!integer_fits(r))
+         return false;
+      load_integer(code, operand, r);
+      return true;
+   }
+   else if(op == code_gen::negate && ty.is_type(lille_type::type_real))
+   {
+      float r = -code->real_constant(operand);
+      code->truncate(operand);
+      code->emit_real(r, "Load real value.");
+      return true;
+   }
+   else if(op == code_gen::logical_not && ty.is_type(lille_type::type_boolean))
+   {
+      load_boolean(code, operand, code->integer_constant(operand) == 0);
+      return true;
+   }
+   else if(op == code_gen::odd && ty.is_type(lille_type::type_integer))
+   {
+      load_boolean(code, operand, code->integer_constant(operand) % 2 != 0);
+      ty = lille_type::type_boolean;
+      return true;
+   }
+   return false;
+}
+
+// Evaluate a call of INT2STRING at compile time when its argument is an integer constant. The call was compiled from
+// address start on and its argument, the last instruction emitted, from address args on.
+bool parser::fold_call(int start, int args, id_table_entry* routine)
+{
+   if(!folding || code->next_address() != args + 1 || !code->is_constant(args) ||
+      routine->number_of_params() != 1 || !routine->nth_parameter(1)->tipe().is_type(lille_type::type_integer))
+      return false;
+
+   for(const auto& [function, conversion] : predefined)
+      if(function == routine && conversion == code_gen::int_to_string)
+      {
+         int value = code->integer_constant(args);
+         code->truncate(start);
+         code->emit_string_copy(to_string(value), "Load string value.");
+         return true;
+      }
+   return false;
+}
+
+// Define a function in the symbol table with its name, return type, and argument type, and generate its code.
+// Each predefined function loads its argument, converts it and returns the result.
+void parser::define_function(string name, lille_type x, lille_type y, code_gen::opr_code conversion, string_view comment)
 {
    token* fun, * arg;
-   symbol* sym;
-   id_table_entry* fun_id, * param_id;
+   symbol sym(symbol::identifier);
+   id_table_entry* fun_id;
 
-   // Create a symbol and token for the function name.
-   sym = new symbol(symbol::identifier);
-   fun = new token(sym, 0, 0);
+   // Create a token for the function name.
+   fun = scan->new_token(sym, 0, 0);
    fun->set_identifier_value(name);
 
    // Enter the function into the symbol table.
    fun_id = id_tab->enter_id(fun, lille_type::type_func, lille_kind::unknown, 0, 0, x);
-   id_tab->add_table_entry(fun_id);
 
    // Create a token for the function argument.
-   arg = new token(sym, 0, 0);
-   arg->set_identifier_value("__" + name + "_arg__"); 
+   arg = scan->new_token(sym, 0, 0);
+   arg->set_identifier_value("__" + name + "_arg__");
 
    // Enter the argument into the symbol table as a parameter of the function.
-   param_id = new id_table_entry(arg, y, lille_kind::value_param, 0, 0, lille_type::type_unknown);
-   fun_id->add_param(param_id);
-
+   id_tab->enter_param(fun_id, arg, y, lille_kind::value_param, 1, 0);
+
+   // Generate the body of the function.
+   int entry = code->emit(code_gen::LDV, 0, 0, "Load argument.");
+   code->emit_opr(conversion, comment);
+   code->emit_opr(code_gen::function_return, "Function value return.");
+   fun_id->fix_code_address(entry);
+   fun_id->fix_body(entry, entry + 2, 1);
+   predefined.push_back({fun_id, conversion});
 }
 
 // Program entry point in the parser.
@@ -63,28 +509,31 @@ void parser::prog()
    scan->must_be(symbol::program_sym);
 
    // Create a token for the program name and enter it into the symbol table.
-   symbol* sym = new symbol(symbol::program_sym);
-   token* prog = new token(sym, 0, 0);
-   prog->set_prog_value(scan->get_current_identifier_name());
+   symbol sym(symbol::program_sym);
+   token* prog = scan->new_token(sym, 0, 0);
+   prog->set_prog_value(scan->keep_text(scan->get_current_identifier_name()));
    id_table_entry* prog_id = id_tab->enter_id(prog, lille_type::type_prog, lille_kind::unknown, id_tab->scope(), 0, lille_type::type_unknown);
-   id_tab->add_table_entry(prog_id);
    curr_entry = prog_id;
 
 
    // Ensure the program name is an identifier.
    scan->must_be(symbol::identifier);
 
-   // Define built-in functions.
-   parser::define_function("INT2REAL", lille_type::type_real, lille_type::type_integer);
-   parser::define_function("REAL2INT", lille_type::type_integer, lille_type::type_real);
-   parser::define_function("INT2STRING", lille_type::type_string, lille_type::type_integer);
-   parser::define_function("REAL2STRING", lille_type::type_string, lille_type::type_real);
+   // Define built-in functions. The program starts by jumping over their code.
+   int skip = code->new_label();
+   code->emit_jump(code_gen::JMP, skip, "Jump over the predefined functions.");
+   parser::define_function("INT2REAL", lille_type::type_real, lille_type::type_integer, code_gen::int_to_real, "Convert an integer to a real.");
+   parser::define_function("REAL2INT", lille_type::type_integer, lille_type::type_real, code_gen::real_to_int, "Convert an real to an integer.");
+   parser::define_function("INT2STRING", lille_type::type_string, lille_type::type_integer, code_gen::int_to_string, "Convert an integer to a string.");
+   parser::define_function("REAL2STRING", lille_type::type_string, lille_type::type_real, code_gen::real_to_string, "Convert an real to a string.");
+   code->define_label(skip);
 
    // Ensure the program declaration is followed by "is".
    scan->must_be(symbol::is_sym);
 
-   // Process the block of the program.
-   block();
+   // Process the block of the program, in a scope of its own inside that of the predefined functions.
+   id_tab->enter_scope();
+   block(prog_id);
 
    // Ensure the program ends with a semicolon and the end of the program symbol.
    scan->must_be(symbol::semicolon_sym);
@@ -94,17 +543,39 @@ void parser::prog()
       cout << "Parser: exiting prog()" << endl;
 }
 
-// Process a block of code.
-void parser::block()
+// Process a block of code. The block reserves space for its frame and jumps over the code of any routines declared
+// in it to its statements. The size of the frame is filled in once the whole block has been compiled.
+void parser::block(id_table_entry* routine)
 {
    if(debugging)
       cout << "Parser: entering block()" << endl;
 
+   int params = next_offset;       // parameters have already been given the first words of the frame
+   bool locals_reserved = false;
+   bool nested_routines = false;
+
+   int reserve = code->emit(code_gen::INC, 0, 0, "Reserve space for local variables");
+   if(!routine->tipe().is_type(lille_type::type_prog))
+      routine->fix_code_address(reserve);
+   int skip = code->new_label();
+   code->emit_jump(code_gen::JMP, skip, "Jump to start of statements or block.");
+
    // Process declarations until "begin" is encountered.
    while (scan->have(symbol::identifier) || scan->have(symbol::function_sym) || scan->have(symbol::procedure_sym))
    {
+      if(!scan->have(symbol::identifier))
+         nested_routines = true;
+      if(!locals_reserved && !scan->have(symbol::identifier))
+      {
+         reserve_locals(params);
+         locals_reserved = true;
+      }
       decl();
    }
+   if(!locals_reserved)
+      reserve_locals(params);
+   int body = code->next_address();
+   code->define_label(skip);
 
    // Ensure the block starts with "begin".
    scan->must_be(symbol::begin_sym);
@@ -112,6 +583,23 @@ void parser::block()
    // Process statements.
    statementList();
 
+   // Leave the block.
+   if(routine->tipe().is_type(lille_type::type_func))
+   {
+      code->emit_string("ERROR OCCURED - FUNCTION MUST RETURN A VALUE.", "A function must return a value before the end of block is encountered.");
+      code->emit_opr(code_gen::write_value, "Display message.");
+      code->emit(code_gen::JMP, 0, 0, "Halt program after error.");
+   }
+   else if(routine->tipe().is_type(lille_type::type_proc))
+      code->emit_opr(code_gen::procedure_return, "Procedure return.");
+   else
+      code->emit(code_gen::JMP, 0, 0, "Halt program.");
+   code->patch(reserve, frame_size);
+
+   // The statements of a routine that declares no routines of its own can be copied in place of a call.
+   if(!routine->tipe().is_type(lille_type::type_prog) && !nested_routines)
+      routine->fix_body(body, code->next_address() - 1, frame_size);
+
    // Ensure the block ends with "end".
    scan->must_be(symbol::end_sym);
 
@@ -133,7 +621,7 @@ vector<token*> parser::identList()
 {
    if(debugging)
       cout << "Parser: entering identList()" << endl;
- 
+
    vector<token*> tokens;
    if(scan->have(symbol::identifier))
    {
@@ -165,57 +653,60 @@ void parser::decl()
    bool comma_found = false;
    lille_type ty;
 
-   // Process a procedure declaration.
-   if(scan->have(symbol::procedure_sym))
+   // Process a procedure or function declaration.
+   if(scan->have(symbol::procedure_sym) || scan->have(symbol::function_sym))
    {
-      scan->must_be(symbol::procedure_sym);
+      bool is_function = scan->have(symbol::function_sym);
+      scan->must_be(is_function ? symbol::function_sym : symbol::procedure_sym);
+
+      // Enter the routine in the scope in which it is declared.
+      token* name = scan->this_token();
       scan->must_be(symbol::identifier);
-      
-      // Process procedure parameters if present
+      id_table_entry* routine = id_tab->enter_id(name, is_function ? lille_type::type_func : lille_type::type_proc, lille_kind::unknown, id_tab->scope(), 0, lille_type::type_unknown);
+
+      // The routine has its own scope and frame, closed by block(), whether or not it has parameters.
+      int saved_offset = next_offset;
+      int saved_frame_size = frame_size;
+      id_table_entry* saved_routine = curr_func_proc;
+      int saved_loop_return = loop_return;
+      next_offset = 0;
+      frame_size = 0;
+      curr_func_proc = routine;
+      loop_return = -1;
+      id_tab->enter_scope();
+
+      // Process routine parameters if present
       if(scan->have(symbol::left_paren_sym))
       {
          scan->must_be(symbol::left_paren_sym);
-         id_tab->enter_scope();
-         paramList();
+         paramList(routine);
          scan->must_be(symbol::right_paren_sym);
       }
 
-      scan->must_be(symbol::is_sym);
-      block();
-
-   }
-   // Process a function declaration
-   else if(scan->have(symbol::function_sym))
-   {
-      scan->must_be(symbol::function_sym);
-      scan->must_be(symbol::identifier);
-      
-      // Process function parameters
-      if(scan->have(symbol::left_paren_sym))
+      if(is_function)
       {
-         scan->must_be(symbol::left_paren_sym);
-         id_tab->enter_scope();
-         paramList();
-         scan->must_be(symbol::right_paren_sym);
+         scan->must_be(symbol::return_sym);
+         routine->fix_return_type(type());
       }
-
-      scan->must_be(symbol::return_sym);
-      type();
       scan->must_be(symbol::is_sym);
-      block();
+      block(routine);
 
+      next_offset = saved_offset;
+      frame_size = saved_frame_size;
+      curr_func_proc = saved_routine;
+      loop_return = saved_loop_return;
    }
    // Process variable or constant declaration.
    else if (scan->have(symbol::identifier))
    {
       bool const_decl = false;
-      float r_const;
-      int i_const;
-      std::string s_const;
-      bool b_const;
+      float r_const = 0.0;
+      int i_const = 0;
+      string_view s_const;
+      bool b_const = false;
       id_table_entry* id_tab_ent;
       tokens = identList();
-      
+
       scan->must_be(symbol::colon_sym);
       if(scan->have(symbol::constant_sym))
       {
@@ -226,53 +717,56 @@ void parser::decl()
       if(scan->have(symbol::becomes_sym))
       {
          scan->must_be(symbol::becomes_sym);
-      
+
          if(scan->have(symbol::integer))
          {
             i_const = scan->this_token()->get_integer_value();
             if(!ty.is_type(lille_type::type_integer))
-               error->flag(scan->this_token(), 111); //const expr doesn't match its type declaration
+               error->flag(scan->this_token(), lille_error::constant_type_mismatch); //const expr doesn't match its type declaration
             scan->must_be(symbol::integer);
          }
          else if(scan->have(symbol::real_num))
          {
             r_const = scan->this_token()->get_real_value();
             if (!ty.is_type(lille_type::type_real))
-               error->flag(scan->this_token(), 111); //const expr doesn't match its type declaration
+               error->flag(scan->this_token(), lille_error::constant_type_mismatch); //const expr doesn't match its type declaration
             scan->must_be(symbol::real_num);
          }
          else if(scan->have(symbol::strng))
          {
             s_const = scan->this_token()->get_string_value();
             if (!ty.is_type(lille_type::type_string))
-               error->flag(scan->this_token(), 111); //const expr doesn't match its type declaration
+               error->flag(scan->this_token(), lille_error::constant_type_mismatch); //const expr doesn't match its type declaration
             scan->must_be(symbol::strng);
          }
          else if (scan->have(symbol::false_sym))
          {
             b_const = false;
             if (!ty.is_type(lille_type::type_boolean))
-               error->flag(scan->this_token(), 111); //const expr doesn't match its type declaration
-            scan->must_be(symbol::boolean_sym);
+               error->flag(scan->this_token(), lille_error::constant_type_mismatch); //const expr doesn't match its type declaration
+            scan->must_be(symbol::false_sym);
          }
          else if (scan->have(symbol::true_sym))
          {
             b_const = true;
             if (!ty.is_type(lille_type::type_boolean))
-               error->flag(scan->this_token(), 111); //const expr doesn't match its type declaration
+               error->flag(scan->this_token(), lille_error::constant_type_mismatch); //const expr doesn't match its type declaration
             scan->get_token();
          }
       }
+      // Variables are given the next words of the frame. Constants are loaded by value, so need no space.
       for (int i = 0; i<tokens.size(); i++)
       {
-         id_tab_ent = id_tab->enter_id(tokens[i], ty, const_decl ? lille_kind::constant : lille_kind::variable, id_tab->scope(), 0, lille_type::type_unknown);
-         if(const_decl = true)
+         id_tab_ent = id_tab->enter_id(tokens[i], ty, const_decl ? lille_kind::constant : lille_kind::variable, id_tab->scope(), const_decl ? 0 : next_offset, lille_type::type_unknown);
+         if(const_decl)
             id_tab_ent->fix_const(i_const, r_const, s_const, b_const);
+         else
+            frame_size = max(frame_size, ++next_offset);
       }
    }
 
    scan->must_be(symbol::semicolon_sym);
-   
+
 
    if(debugging)
       cout << "Parser: exiting decl()" << endl;
@@ -310,7 +804,7 @@ lille_type parser::type()
    /*
    else
    {
-      error->flag(scan->this_token(), 129);
+      error->flag(scan->this_token(), lille_error::invalid_type_syntax);
       scan->get_token();
    }
    */
@@ -319,61 +813,74 @@ lille_type parser::type()
 }
 
 // Process a list of parameters.
-void parser::paramList()
+void parser::paramList(id_table_entry* routine)
 {
    if(debugging)
       cout << "Parser: entering paramList()" << endl;
    // Process the first parameter.
-   param();
+   param(routine);
 
    // Process the rest of the parameters separated by semicolons.
    while(scan->have(symbol::semicolon_sym))
    {
       scan->must_be(symbol::semicolon_sym);
-      param();
+      param(routine);
    }
    if(debugging)
       cout << "Parser: exiting paramList()" << endl;
 }
 
-// Process a single parameter.
-void parser::param()
+// Process a single parameter. Parameters take the first words of the routine's frame, in order.
+void parser::param(id_table_entry* routine)
 {
    if(debugging)
       cout << "Parser: entering param()" << endl;
    // Process a list of identifiers representing parameters.
-   identList();
+   vector<token*> tokens = identList();
 
    // Make sure a colon separates the parameter list from its type.
    scan->must_be(symbol::colon_sym);
 
    // Process the kind of parameter (value or reference) and its type.
-   paramKind();
-   type();
+   lille_kind kind = paramKind();
+   lille_type ty = type();
+
+   for(token* tok : tokens)
+   {
+      id_tab->enter_param(routine, tok, ty, kind, id_tab->scope(), next_offset);
+      frame_size = max(frame_size, ++next_offset);
+   }
 
    if(debugging)
       cout << "Parser: exiting param()" << endl;
 }
 
 // Determine the kind of parameter (value or reference)
-void parser::paramKind()
+lille_kind parser::paramKind()
 {
    if(debugging)
       cout << "Parser: entering paramKind()" << endl;
 
+   lille_kind kind = lille_kind::value_param;
+
    // Check for the presence of 'value' or 'ref' symbols and consume them.
    if(scan->have(symbol::value_sym))
       scan->must_be(symbol::value_sym);
    else if(scan->have(symbol::ref_sym))
+   {
       scan->must_be(symbol::ref_sym);
+      kind = lille_kind::ref_param;
+   }
    /*
    else
    {
-      error->flag(scan->this_token(), 128); //paramKind must be a value or a ref symbol
+      error->flag(scan->this_token(), lille_error::invalid_param_kind_syntax); //paramKind must be a value or a ref symbol
    }
    */
    if(debugging)
       cout << "Parser: exiting paramKind()" << endl;
+
+   return kind;
 }
 
 // Process a list of statements
@@ -398,7 +905,7 @@ void parser::statementList()
 void parser::statement()
 {
    if(debugging)
-      cout << "Parser: entering statement()" << endl; 
+      cout << "Parser: entering statement()" << endl;
 
    // Check the type of statement and call the appropriate function.
    if(scan->have(symbol::identifier) || scan->have(symbol::exit_sym) || scan->have(symbol::return_sym) ||
@@ -413,7 +920,7 @@ void parser::statement()
    /*
    else
    {
-      error->flag(scan->this_token(), 124); //statement must contain a simple or compound statement.
+      error->flag(scan->this_token(), lille_error::invalid_statement_syntax); //statement must contain a simple or compound statement.
    }
    */
    if(debugging)
@@ -429,21 +936,40 @@ void parser::simpleStatement()
    // Check the type of simple statement and process accordingly.
    if(scan->have(symbol::exit_sym))
    {
-      // Handle EXIT statement.
+      // Handle EXIT statement. The jump out of the loop is filled in when the loop is closed.
+      if(exit_labels.empty())
+         error->flag(scan->this_token(), lille_error::exit_outside_loop);
       scan->must_be(symbol::exit_sym);
+      int stay = -1;
       if(scan->have(symbol::when_sym))
       {
          scan->must_be(symbol::when_sym);
          expr();
+         stay = code->new_label();
+         code->emit_jump(code_gen::JIF, stay, "Do not exit loop.");
       }
+      if(!exit_labels.empty())
+         code->emit_jump(code_gen::JMP, exit_labels.back(), "Unconditional jump.");
+      else
+         code->emit(code_gen::JMP, 0, 0, "Unconditional jump.");
+      if(stay != -1)
+         code->define_label(stay);
    }
    else if(scan->have(symbol::return_sym))
    {
       // Handle RETURN statement
+      token* tok = scan->this_token();
       scan->must_be(symbol::return_sym);
-      if(scan->have(symbol::identifier) || scan->have(symbol::integer) || scan->have(symbol::real_num) || scan->have(symbol::strng)
-         || scan->have(symbol::boolean_sym))
+      if(starts_expr())
          expr();
+      if(curr_func_proc == NULL)
+         error->flag(tok, lille_error::return_outside_routine);
+      else if(!loop_frames.empty())
+         return_from_loop();
+      else if(curr_func_proc->tipe().is_type(lille_type::type_func))
+         code->emit_opr(code_gen::function_return, "Function value return.");
+      else
+         code->emit_opr(code_gen::procedure_return, "Procedure return.");
    }
    else if(scan->have(symbol::read_sym))
    {
@@ -455,85 +981,94 @@ void parser::simpleStatement()
          parenOpen = true;
          scan->must_be(symbol::left_paren_sym);
       }
-      identList();
-      
-      if (parenOpen)
-         scan->must_be(symbol::right_paren_sym);
-   }
-   else if(scan->have(symbol::write_sym))
-   {
-      // Handle WRITE statement
-      bool parenOpen = false;
-      scan->must_be(symbol::write_sym);
-      if(scan->have(symbol::left_paren_sym))
+      for(token* tok : identList())
       {
-         parenOpen = true;
-         scan->must_be(symbol::left_paren_sym);
-         if(scan->have(symbol::right_paren_sym))
+         id_table_entry* entry = id_tab->lookup(tok);
+         if(entry == NULL)
+            error->flag(tok, lille_error::undeclared_identifier);
+         else if(!entry->kind().is_kind(lille_kind::variable) && !entry->kind().is_kind(lille_kind::ref_param))
+            error->flag(tok, lille_error::not_assignable);   // Identifier is not assignable.
+         else if(!entry->tipe().is_type(lille_type::type_integer) && !entry->tipe().is_type(lille_type::type_real))
+            error->flag(tok, lille_error::int_or_real_variable_expected);
+         else
          {
-            error->flag(scan->this_token(),83);
+            bool real = entry->tipe().is_type(lille_type::type_real);
+            code_gen::op_code op = real ? code_gen::RDR : code_gen::RDI;
+            string_view comment = real ? "Read real value." : "Read integer value.";
+
+            if(entry->kind().is_kind(lille_kind::variable))
+               code->emit(op, level_diff(entry), entry->offset(), comment);
+            else
+            {
+               // A ref parameter holds the address of the variable, so read into a temporary and store it there.
+               int temp = new_temp();
+               code->emit(op, 0, temp, comment);
+               code->emit(code_gen::LDV, 0, temp, "Load the value read.");
+               store(entry, tok);
+               release_temp();
+            }
          }
       }
-      expr();
 
-      while(scan->have(symbol::comma_sym))
-      {
-         scan->must_be(symbol::comma_sym);
-         expr();
-      }
-      if(parenOpen)
+      if (parenOpen)
          scan->must_be(symbol::right_paren_sym);
    }
-   else if(scan->have(symbol::writeln_sym))
+   else if(scan->have(symbol::write_sym) || scan->have(symbol::writeln_sym))
    {
-      // Handle WRITELN statement.
+      // Handle WRITE and WRITELN statements. Each expression is written as soon as it has been evaluated.
       bool parenOpen = false;
-      scan->must_be(symbol::writeln_sym);
+      bool new_line = scan->have(symbol::writeln_sym);
+      scan->must_be(new_line ? symbol::writeln_sym : symbol::write_sym);
       if(scan->have(symbol::left_paren_sym))
       {
          parenOpen = true;
          scan->must_be(symbol::left_paren_sym);
          if(scan->have(symbol::right_paren_sym))
          {
-            error->flag(scan->this_token(), 83);
+            error->flag(scan->this_token(), lille_error::simple_statement_expected);
          }
       }
-      expr();
-
-      while(scan->have(symbol::comma_sym))
+      if(parenOpen || !new_line || starts_expr())
       {
-         scan->must_be(symbol::comma_sym);
-         expr();
+         lille_type ty = expr();
+         code->emit_opr(code_gen::write_value, ty.is_type(lille_type::type_string) ? "Write string value." : "Write integer or real value.");
+
+         while(scan->have(symbol::comma_sym))
+         {
+            scan->must_be(symbol::comma_sym);
+            ty = expr();
+            code->emit_opr(code_gen::write_value, ty.is_type(lille_type::type_string) ? "Write string value." : "Write integer or real value.");
+         }
       }
       if(parenOpen)
          scan->must_be(symbol::right_paren_sym);
+      if(new_line)
+         code->emit_opr(code_gen::write_line, "Terminate output to the current line.");
    }
    else if(scan->have(symbol::null_sym))
       scan->must_be(symbol::null_sym);
    else if(scan->have(symbol::identifier))
    {
-      // Handle assignment or function call.
-      string current_entry_name = scan->get_current_identifier_name();
-      curr_entry = id_tab->lookup(current_entry_name);
+      // Handle assignment or procedure call.
+      token* tok = scan->this_token();
+      curr_entry = id_tab->lookup(tok);
+      scan->must_be(symbol::identifier);
 
-      /*
       if(curr_entry == NULL)
-      {
-         cout << "Error: Identifier not previously declared." << endl;
-         //error->flag(scan->this_token(), 81); // Identifier not previously declared
-      }
-      
+         error->flag(tok, lille_error::undeclared_identifier); // Identifier not previously declared
+      else if(curr_entry->tipe().is_type(lille_type::type_prog))
+         error->flag(tok, lille_error::illegal_identifier);
 
-      if(curr_entry->tipe().is_type(lille_type::type_prog))
+      if(curr_entry != NULL && curr_entry->tipe().is_type(lille_type::type_proc))
       {
-         error->flag(scan->this_token(), 91);
+         // Process a procedure call.
+         call(curr_entry);
       }
-      */
-      
-      scan->must_be(symbol::identifier);
-      if(scan->have(symbol::left_paren_sym))
+      else if(scan->have(symbol::left_paren_sym))
       {
-         // Process a function call.
+         // Only a procedure can be called as a statement. Parse the parameters anyway.
+         if(curr_entry != NULL)
+            error->flag(tok, lille_error::procedure_name_expected);
          scan->must_be(symbol::left_paren_sym);
          expr();
          while(scan->have(symbol::comma_sym))
@@ -545,10 +1080,13 @@ void parser::simpleStatement()
       }
       else if(scan->have(symbol::becomes_sym))
       {  // Process assignment
+         id_table_entry* target = curr_entry;
          scan->must_be(symbol::becomes_sym);
          expr();
+         if(target != NULL)
+            store(target, tok);
       }
-      
+
    }
    if(debugging)
       cout << "Parser: exiting simpleStatement()" << endl;
@@ -567,7 +1105,13 @@ void parser::compoundStatement()
    }
    else if(scan->have(symbol::loop_sym))
    {
+      // A bare loop repeats until an exit statement leaves it.
+      int start = code->new_label();
+      code->define_label(start);
+      open_loop();
       loopStatement();
+      code->emit_jump(code_gen::JMP, start, "Jump to start of loop.");
+      close_loop();
    }
    else if(scan->have(symbol::for_sym))
    {
@@ -580,7 +1124,7 @@ void parser::compoundStatement()
    /*
    else
    {
-      error->flag(scan->this_token(), 125);
+      error->flag(scan->this_token(), lille_error::invalid_compound_statement_syntax);
       scan->get_token();
    }
    */
@@ -588,23 +1132,34 @@ void parser::compoundStatement()
       cout << "Parser: exiting compoundStatement()" << endl;
 }
 
-// Process an IF statement.
+// Process an IF statement. Each condition jumps past its statements when false, and each group of statements
+// jumps to the end of the whole statement.
 void parser::ifStatement()
 {
    if(debugging)
       cout << "Parser: entering ifStatement()" << endl;
-   
+
+   int end = code->new_label();
+
    scan->must_be(symbol::if_sym);
    expr();
+   int next = code->new_label();
+   code->emit_jump(code_gen::JIF, next, "Jump if false.");
    scan->must_be(symbol::then_sym);
    statementList();
+   code->emit_jump(code_gen::JMP, end, "Unconditional jump.");
+   code->define_label(next);
 
    while(scan->have(symbol::elsif_sym))
    {
       scan->must_be(symbol::elsif_sym);
       expr();
+      next = code->new_label();
+      code->emit_jump(code_gen::JIF, next, "Jump if false.");
       scan->must_be(symbol::then_sym);
       statementList();
+      code->emit_jump(code_gen::JMP, end, "Unconditional jump.");
+      code->define_label(next);
    }
    if(scan->have(symbol::else_sym))
    {
@@ -615,6 +1170,8 @@ void parser::ifStatement()
    scan->must_be(symbol::end_sym);
    scan->must_be(symbol::if_sym);
 
+   code->define_label(end);
+
    if(debugging)
       cout << "Parser: exiting ifStatement()" << endl;
 }
@@ -625,38 +1182,181 @@ void parser::whileStatement()
    if(debugging)
       cout << "Parser: entering whileStatement()" << endl;
    scan->must_be(symbol::while_sym);
+   int start = code->new_label();
+   code->define_label(start);
    expr();
+   open_loop();
+   code->emit_jump(code_gen::JIF, exit_labels.back(), "Jump if false.");
    loopStatement();
+   code->emit_jump(code_gen::JMP, start, "Jump to start of loop.");
+   close_loop();
    if(debugging)
       cout << "Parser: exiting whileStatement()" << endl;
 }
 
-// Process a for statement.
+// Process a for statement. The loop is compiled as a parameterless procedure with its own frame, holding the loop
+// parameter and the start and end values of the range. The procedure is jumped over and then called.
 void parser::forStatement()
 {
    if(debugging)
       cout << "Parser: entering forStatement()" << endl;
    scan->must_be(symbol::for_sym);
+   if(inline_for)
+   {
+      inlineForStatement();
+      return;
+   }
+   int skip = code->new_label();
+   code->emit_jump(code_gen::JMP, skip, "Unconditional jump.");
+
+   loop_frames.push_back({next_offset, frame_size});
+   int returns = loop_returns;
+   next_offset = 3;
+   frame_size = 3;
    id_tab->enter_scope();
    //id table entry for for loop identifier (i, j, k, etc)
-   symbol* sym = new symbol(symbol::identifier);
-   token* tok = new token(sym, 0, 0);
-   tok->set_identifier_value(scan->get_current_identifier_name());
-   id_table_entry* forEntry = id_tab->enter_id(tok, lille_type::type_integer, lille_kind::for_ident, id_tab->scope(), 0, lille_type::type_unknown);
-   id_tab->add_table_entry(forEntry);
+   symbol sym(symbol::identifier);
+   token* tok = scan->new_token(sym, 0, 0);
+   tok->set_identifier_atom(scan->get_current_identifier_atom());
+   id_tab->enter_id(tok, lille_type::type_integer, lille_kind::for_ident, id_tab->scope(), 0, lille_type::type_unknown);
+   int reserve = code->emit(code_gen::INC, 0, 3, "Reserve space for for-loop control variable, lb and ub values.");
 
    scan->must_be(symbol::identifier);
    scan->must_be(symbol::in_sym);
-   if(scan->have(symbol::reverse_sym))
+   bool reverse = scan->have(symbol::reverse_sym);
+   if(reverse)
       scan->must_be(symbol::reverse_sym);
 
-   range();
+   range(reverse);
+
+   int test = code->new_label();
+   code->define_label(test);
+   code->emit(code_gen::LDV, 0, 0, "Load the value of the for loop parameter.");
+   code->emit(code_gen::LDV, 0, 2, "Load the end value of the for loop.");
+   if(reverse)
+      code->emit_opr(code_gen::greater_or_equal, "Check if loop parameter >= end value.");
+   else
+      code->emit_opr(code_gen::less_or_equal, "Check if loop parameter <= end value.");
+   open_loop();
+   code->emit_jump(code_gen::JIF, exit_labels.back(), "Jump if false.");
    loopStatement();
 
+   code->emit(code_gen::LDV, 0, 0, "Load the value of the for loop parameter.");
+   code->emit(code_gen::LCI, 0, 1, "Load the value 1 onto the stack.");
+   if(reverse)
+      code->emit_opr(code_gen::subtract, "Subtract values.");
+   else
+      code->emit_opr(code_gen::add, "Add values.");
+   code->emit(code_gen::STO, 0, 0, "Store value of for loop parameter.");
+   code->emit_jump(code_gen::JMP, test, "Jump to beginning of for loop for next iteration.");
+   close_loop();
+   code->emit_opr(code_gen::procedure_return, "Return from for loop.");
+   code->patch(reserve, frame_size);
+
+   id_tab->exit_scope();
+   next_offset = loop_frames.back().first;
+   frame_size = loop_frames.back().second;
+   loop_frames.pop_back();
+
+   code->define_label(skip);
+   bool returned = loop_returns != returns;
+   if(returned && loop_frames.empty())
+   {
+      code->emit(code_gen::LCI, 0, 0, "Load boolean value.");
+      code->emit(code_gen::STO, 0, loop_return, "Clear the return flag of the routine.");
+   }
+   code->emit(code_gen::MST, 0, 0, "Mark stack for for loop.");
+   code->emit(code_gen::CAL, 0, reserve, "Effectively call the for loop - 0 parameters.");
+
+   // Carry a return made inside the loop on out of the enclosing loops and routine.
+   if(returned)
+   {
+      int stay = code->new_label();
+      code->emit(code_gen::LDV, loop_frames.size(), loop_return, "Load the return flag of the routine.");
+      code->emit_jump(code_gen::JIF, stay, "Jump if the for loop did not return.");
+      if(!loop_frames.empty())
+         code->emit_opr(code_gen::procedure_return, "Return from for loop.");
+      else if(curr_func_proc->tipe().is_type(lille_type::type_func))
+      {
+         code->emit(code_gen::LDV, 0, loop_return + 1, "Load the function value.");
+         code->emit_opr(code_gen::function_return, "Function value return.");
+      }
+      else
+         code->emit_opr(code_gen::procedure_return, "Procedure return.");
+      code->define_label(stay);
+   }
+
    if(debugging)
       cout << "Parser: exiting forStatement()" << endl;
 }
 
+// Process a for statement in line. The loop parameter and the end value of the range are kept in two words of the
+// frame of the enclosing block, which are released after the loop, and an exit jumps straight past the loop.
+void parser::inlineForStatement()
+{
+   if(debugging)
+      cout << "Parser: entering inlineForStatement()" << endl;
+
+   id_tab->enter_scope();
+   inline_scopes.push_back(id_tab->scope());
+   int var = new_temp();
+   int end = new_temp();
+
+   //id table entry for for loop identifier (i, j, k, etc)
+   symbol sym(symbol::identifier);
+   token* tok = scan->new_token(sym, 0, 0);
+   tok->set_identifier_atom(scan->get_current_identifier_atom());
+   id_tab->enter_id(tok, lille_type::type_integer, lille_kind::for_ident, id_tab->scope(), var, lille_type::type_unknown);
+
+   scan->must_be(symbol::identifier);
+   scan->must_be(symbol::in_sym);
+   bool reverse = scan->have(symbol::reverse_sym);
+   if(reverse)
+      scan->must_be(symbol::reverse_sym);
+
+   simpleExpr();
+   if(reverse)
+      code->emit(code_gen::STO, 0, end, "Store the lower bound of the range as the end value of the loop.");
+   else
+      code->emit(code_gen::STO, 0, var, "Store the lower bound of the range as initial value of for loop parameter.");
+   scan->must_be(symbol::range_sym);
+   simpleExpr();
+   if(reverse)
+      code->emit(code_gen::STO, 0, var, "Store the upper bound of the range as initial value of for loop parameter.");
+   else
+      code->emit(code_gen::STO, 0, end, "Store the upper bound of the range as the end value of the loop.");
+
+   int test = code->new_label();
+   code->define_label(test);
+   code->emit(code_gen::LDV, 0, var, "Load the value of the for loop parameter.");
+   code->emit(code_gen::LDV, 0, end, "Load the end value of the for loop.");
+   if(reverse)
+      code->emit_opr(code_gen::greater_or_equal, "Check if loop parameter >= end value.");
+   else
+      code->emit_opr(code_gen::less_or_equal, "Check if loop parameter <= end value.");
+   open_loop();
+   code->emit_jump(code_gen::JIF, exit_labels.back(), "Jump if false.");
+   loopStatement();
+
+   code->emit(code_gen::LDV, 0, var, "Load the value of the for loop parameter.");
+   code->emit(code_gen::LCI, 0, 1, "Load the value 1 onto the stack.");
+   if(reverse)
+      code->emit_opr(code_gen::subtract, "Subtract values.");
+   else
+      code->emit_opr(code_gen::add, "Add values.");
+   code->emit(code_gen::STO, 0, var, "Store value of for loop parameter.");
+   code->emit_jump(code_gen::JMP, test, "Jump to beginning of for loop for next iteration.");
+   close_loop();
+
+   release_temp();
+   release_temp();
+   inline_scopes.pop_back();
+   id_tab->exit_scope();
+
+   if(debugging)
+      cout << "Parser: exiting inlineForStatement()" << endl;
+}
+
 // Process a loop statement.
 void parser::loopStatement()
 {
@@ -666,141 +1366,212 @@ void parser::loopStatement()
    statementList();
    scan->must_be(symbol::end_sym);
    scan->must_be(symbol::loop_sym);
-   id_tab->exit_scope();
    if(debugging)
       cout << "Parser: exiting loopStatement()" << endl;
 }
 
-// Process a range symbol.
-void parser::range()
+// Process the range of a for loop, storing its bounds in the loop's frame. The loop parameter starts at the lower
+// bound and counts up to the upper bound, or the other way round for a reverse loop.
+void parser::range(bool reverse)
 {
    if(debugging)
       cout << "Parser: entering range()" << endl;
    simpleExpr();
+   if(reverse)
+      code->emit(code_gen::STO, 0, 2, "Store the lower bound of the range as the end value of the loop.");
+   else
+   {
+      code->emit_opr(code_gen::duplicate, "Duplicate top of stack");
+      code->emit(code_gen::STO, 0, 0, "Store the lower bound of the range as initial value of for loop parameter.");
+      code->emit(code_gen::STO, 0, 1, "Store the lower bound of the range as the start value of the loop.");
+   }
    scan->must_be(symbol::range_sym);
    simpleExpr();
+   if(reverse)
+   {
+      code->emit_opr(code_gen::duplicate, "Duplicate top of stack");
+      code->emit(code_gen::STO, 0, 0, "Store the upper bound of the range as initial value of for loop parameter.");
+      code->emit(code_gen::STO, 0, 1, "Store the upper bound of the range as the start value of the loop.");
+   }
+   else
+      code->emit(code_gen::STO, 0, 2, "Store the upper bound of the range as the end value of the loop.");
    if(debugging)
       cout << "Parser: exiting range()" << endl;
 }
 
 // Process an expression.
-void parser::expr()
+lille_type parser::expr()
 {
    if(debugging)
       cout << "Parser: entering expr()" << endl;
-   
+
    // Process the simple expression.
-   simpleExpr();
+   int start = code->next_address();
+   lille_type ty = simpleExpr();
 
    // Process a relational operator and another simple expression if present.
    if(scan->have(symbol::greater_than_sym) || scan->have(symbol::less_than_sym) ||
       scan->have(symbol::equals_sym) || scan->have(symbol::not_equals_sym) ||
       scan->have(symbol::less_or_equal_sym) || scan->have(symbol::greater_or_equal_sym))
    {
-      relOp();
-      simpleExpr();
+      code_gen::opr_code op = relOp();
+      lille_type right = simpleExpr();
+      if(!fold(start, ty, right, op))
+         code->emit_opr(op, "Compare expressions.");
+      ty = lille_type::type_boolean;
    }
 
-   // Process the 'IN' operator and a range if present.
+   // Process the 'IN' operator and a range if present. The value is kept in a temporary so it can be compared with
+   // both bounds.
    else if(scan->have(symbol::in_sym))
    {
       scan->must_be(symbol::in_sym);
-      range();
+      int temp = new_temp();
+      code->emit(code_gen::STO, 0, temp, "Store value to be compared with the range.");
+      code->emit(code_gen::LDV, 0, temp, "Load value to be compared with the range.");
+      simpleExpr();
+      code->emit_opr(code_gen::greater_or_equal, "Compare with the lower bound of the range.");
+      scan->must_be(symbol::range_sym);
+      code->emit(code_gen::LDV, 0, temp, "Load value to be compared with the range.");
+      simpleExpr();
+      code->emit_opr(code_gen::less_or_equal, "Compare with the upper bound of the range.");
+      code->emit_opr(code_gen::logical_and, "Value must be within both bounds.");
+      release_temp();
+      ty = lille_type::type_boolean;
    }
    /*
    else
    {
-      error->flag(scan->this_token(), 127); //Invalid expr syntax
+      error->flag(scan->this_token(), lille_error::invalid_expression_syntax); //Invalid expr syntax
    }
    */
    if(debugging)
       cout << "Parser: exiting expr()" << endl;
+
+   return ty;
 }
 
 // Process a simple expression.
-void parser::simpleExpr()
+lille_type parser::simpleExpr()
 {
    if(debugging)
       cout << "Parser: entering simpleExpr()" << endl;
-   expr2();
+   int start = code->next_address();
+   lille_type ty = expr2();
    while(scan->have(symbol::ampersand_sym))
    {
       scan->must_be(symbol::ampersand_sym);
-      expr2();
+      lille_type right = expr2();
+      if(!fold(start, ty, right, code_gen::concatenate))
+         code->emit_opr(code_gen::concatenate, "Concatenate strings.");
+      ty = lille_type::type_string;
    }
    if(debugging)
       cout << "Parser: exiting simpleExpr()" << endl;
+   return ty;
 }
 
-// Process a relational operator.
-void parser::relOp()
+// Process a relational operator, returning the operation that compares the two expressions.
+code_gen::opr_code parser::relOp()
 {
    if(debugging)
       cout << "Parser: entering relOp()" << endl;
 
+   code_gen::opr_code op = code_gen::equal;
+
    // Check for the presence of differnt relational operators and consume them.
    if(scan->have(symbol::greater_than_sym))
+   {
       scan->must_be(symbol::greater_than_sym);
+      op = code_gen::greater_than;
+   }
    else if(scan->have(symbol::less_than_sym))
+   {
       scan->must_be(symbol::less_than_sym);
+      op = code_gen::less_than;
+   }
    else if(scan->have(symbol::equals_sym))
+   {
       scan->must_be(symbol::equals_sym);
+      op = code_gen::equal;
+   }
    else if(scan->have(symbol::not_equals_sym))
+   {
       scan->must_be(symbol::not_equals_sym);
+      op = code_gen::not_equal;
+   }
    else if(scan->have(symbol::less_or_equal_sym))
+   {
       scan->must_be(symbol::less_or_equal_sym);
+      op = code_gen::less_or_equal;
+   }
    else if(scan->have(symbol::greater_or_equal_sym))
+   {
       scan->must_be(symbol::greater_or_equal_sym);
+      op = code_gen::greater_or_equal;
+   }
    /*
    else
    {
-      error->flag(scan->this_token(), 126);
+      error->flag(scan->this_token(), lille_error::invalid_rel_op_syntax);
       scan->get_token();
    }
    */
    if(debugging)
       cout << "Parser: exiting relOp()" << endl;
+
+   return op;
 }
 
 // Process the second level of expressions.
-void parser::expr2()
+lille_type parser::expr2()
 {
    if(debugging)
       cout << "Parser: entering expr2()" << endl;
    // Process the first term.
-   term();
+   int start = code->next_address();
+   lille_type ty = term();
 
    // Process additional terms connected by '+' or '-' or 'or' symbols.
    while(scan->have(symbol::plus_sym) || scan->have(symbol::minus_sym) || scan->have(symbol::or_sym))
    {
-      // Check and consume the appropriate operator.
+      // Check and consume the appropriate operator, process the next term and combine the two.
       if(scan->have(symbol::plus_sym))
       {
          scan->must_be(symbol::plus_sym);
+         lille_type right = term();
+         if(!fold(start, ty, right, code_gen::add))
+            code->emit_opr(code_gen::add, "Add arithmetic expressions together.");
       }
       else if(scan->have(symbol::minus_sym))
       {
          scan->must_be(symbol::minus_sym);
+         lille_type right = term();
+         if(!fold(start, ty, right, code_gen::subtract))
+            code->emit_opr(code_gen::subtract, "Subtract arithmetic expressions.");
       }
       else if(scan->have(symbol::or_sym))
       {
          scan->must_be(symbol::or_sym);
+         lille_type right = term();
+         if(!fold(start, ty, right, code_gen::logical_or))
+            code->emit_opr(code_gen::logical_or, "Or boolean expressions.");
+         ty = lille_type::type_boolean;
       }
-
-      // Process the next term.
-      term();
    }
    if(debugging)
       cout << "Parser: exiting expr2()" << endl;
+   return ty;
 }
 
 // Process a term in the expression.
-void parser::term()
+lille_type parser::term()
 {
    if(debugging)
       cout << "Parser: entering term()" << endl;
    // Process the first factor.
-   factor();
+   int start = code->next_address();
+   lille_type ty = factor();
 
    // Process additional factors connected by '*' or '/' or 'and' symbols.
    while(scan->have(symbol::slash_sym) || scan->have(symbol::asterisk_sym) || scan->have(symbol::and_sym))
@@ -808,83 +1579,122 @@ void parser::term()
       if(scan->have(symbol::asterisk_sym))
       {
         scan->must_be(symbol::asterisk_sym);
+        lille_type right = factor();
+        if(!fold(start, ty, right, code_gen::multiply))
+           code->emit_opr(code_gen::multiply, "Multiply arithmetic expressions.");
       }
       else if (scan->have(symbol::slash_sym))
       {
          scan->must_be(symbol::slash_sym);
+         lille_type right = factor();
+         if(!fold(start, ty, right, code_gen::divide))
+            code->emit_opr(code_gen::divide, "Divide arithmetic expression at tos-1 by expression at tos.");
       }
       else if (scan->have(symbol::and_sym))
       {
          scan->must_be(symbol::and_sym);
+         lille_type right = factor();
+         if(!fold(start, ty, right, code_gen::logical_and))
+            code->emit_opr(code_gen::logical_and, "And boolean expressions.");
+         ty = lille_type::type_boolean;
       }
-      factor();
    }
    if(debugging)
       cout << "Parser: exiting term()" << endl;
+   return ty;
 }
 
 // Process a factor in the expression.
-void parser::factor()
+lille_type parser::factor()
 {
    if(debugging)
       cout << "Parser: entering factor()" << endl;
-   
+
+   lille_type ty;
+   int start = code->next_address();
+
    if(scan->have(symbol::plus_sym) || scan->have(symbol::minus_sym))
    {
       if(scan->have(symbol::plus_sym))
       {
          scan->must_be(symbol::plus_sym);
+         ty = primary();
       }
       else if(scan->have(symbol::minus_sym))
       {
          scan->must_be(symbol::minus_sym);
+         ty = primary();
+         if(!fold(start, ty, code_gen::negate))
+            code->emit_opr(code_gen::negate, "Negate arithmetic expression.");
       }
-      primary();
    }
    else
    {
-      primary();
+      ty = primary();
       if(scan->have(symbol::power_sym))
       {
          scan->must_be(symbol::power_sym);
-         primary();
+         lille_type right = primary();
+         if(!fold(start, ty, right, code_gen::power))
+            code->emit_opr(code_gen::power, "Raise expression at tos-1 to the power of expression at tos.");
       }
    }
    if(debugging)
       cout << "Parser: exiting factor()" << endl;
+   return ty;
 }
 
 // Process a primary expression.
-void parser::primary()
+lille_type parser::primary()
 {
    if(debugging)
       cout << "Parser: entering primary()" << endl;
+
+   lille_type ty = lille_type::type_unknown;
+   int start = code->next_address();
+
    // Check and process different types of primary expressions.
    if(scan->have(symbol::not_sym))
    {
       // Process the 'NOT' expression.
       scan->must_be(symbol::not_sym);
-      expr();
+      ty = expr();
+      if(!fold(start, ty, code_gen::logical_not))
+         code->emit_opr(code_gen::logical_not, "Negate boolean expression.");
+      ty = lille_type::type_boolean;
    }
    else if(scan->have(symbol::odd_sym))
    {
       // Process the 'ODD' expression
       scan->must_be(symbol::odd_sym);
-      expr();
+      ty = expr();
+      if(!fold(start, ty, code_gen::odd))
+         code->emit_opr(code_gen::odd, "Check if integer is odd.");
+      ty = lille_type::type_boolean;
    }
    else if(scan->have(symbol::left_paren_sym))
    {
       // Process an expression enclosed in parentheses.
       scan->must_be(symbol::left_paren_sym);
-      simpleExpr();
+      ty = expr();
       scan->must_be(symbol::right_paren_sym);
    }
    else if(scan->have(symbol::identifier))
    {
       // Process an identifier, check for a function call.
+      token* tok = scan->this_token();
+      id_table_entry* entry = id_tab->lookup(tok);
       scan->must_be(symbol::identifier);
-      if(scan->have(symbol::left_paren_sym))
+      if(entry == NULL)
+         error->flag(tok, lille_error::undeclared_identifier); // Identifier not previously declared
+
+      if(entry != NULL && entry->tipe().is_type(lille_type::type_func))
+         ty = call(entry);
+      else if(scan->have(symbol::left_paren_sym))
       {
+         // Only a function can be called in an expression. Parse the parameters anyway.
+         if(entry != NULL)
+            error->flag(tok, lille_error::function_call_expected);
          scan->must_be(symbol::left_paren_sym);
          expr();
          while(scan->have(symbol::comma_sym))
@@ -894,42 +1704,57 @@ void parser::primary()
          }
          scan->must_be(symbol::right_paren_sym);
       }
+      else if(entry != NULL && (entry->tipe().is_type(lille_type::type_proc) || entry->tipe().is_type(lille_type::type_prog)))
+         error->flag(tok, lille_error::illegal_identifier);
+      else if(entry != NULL)
+         ty = load(entry);
    }
    else if (scan->have(symbol::integer))
    {
       // Process an integer literal.
+      code->emit(code_gen::LCI, 0, scan->this_token()->get_integer_value(), "Load integer value.");
       scan->must_be(symbol::integer);
+      ty = lille_type::type_integer;
    }
    else if (scan->have(symbol::real_num))
    {
       // Process a real number literal.
+      code->emit_real(scan->this_token()->get_real_value(), "Load real value.");
       scan->must_be(symbol::real_num);
+      ty = lille_type::type_real;
    }
    else if (scan->have(symbol::strng))
    {
       // Process a string literal.
+      code->emit_string(scan->this_token()->get_string_value(), "Load string value.");
       scan->must_be(symbol::strng);
+      ty = lille_type::type_string;
    }
    else if (scan->have(symbol::true_sym))
    {
       // Process the 'TRUE' boolean literal.
+      code->emit(code_gen::LCI, 0, 1, "Load boolean value.");
       scan->must_be(symbol::true_sym);
+      ty = lille_type::type_boolean;
    }
    else if (scan->have(symbol::false_sym))
    {
       // Process the 'FALSE' boolean literal.
+      code->emit(code_gen::LCI, 0, 0, "Load boolean value.");
       scan->must_be(symbol::false_sym);
+      ty = lille_type::type_boolean;
    }
-   
+
    /*
    else
    {
-      error->flag(scan->this_token(), 127);
+      error->flag(scan->this_token(), lille_error::invalid_primary_syntax);
       scan->get_token();
    }
    */
    if(debugging)
       cout << "Parser: exiting primary()" << endl;
+   return ty;
 }
 
 // Start the parser by getting the first token and calling prog().
@@ -946,12 +1771,3 @@ void parser::program()
 
 
 }
-
-
-
-
-
-
-
-
-
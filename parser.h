@@ -15,6 +15,7 @@
 #include "error_handler.h"
 #include "id_table.h"
 #include "scanner.h"
+#include "code_gen.h"
 
 using namespace std;
 
@@ -26,28 +27,64 @@ private:
 	error_handler* error;
 	scanner* scan;
         id_table* id_tab;
+        code_gen* code;
 	bool typeFlag{false};
 	parser(); //default constructor for the parser.
         id_table_entry* curr_entry;
-        id_table_entry* curr_func_proc;
+        id_table_entry* curr_func_proc;    // routine whose body is being compiled, NULL in the main program
         id_table_entry* curr_ident;
 
+        int next_offset;                   // next free word in the frame of the block being compiled
+        int frame_size;                    // words needed so far by the frame of the block being compiled
+        vector<int> exit_labels;           // label after each enclosing loop, that of the innermost loop last
+        vector<pair<int, int>> loop_frames;  // next_offset and frame_size outside each enclosing for loop routine
+        int loop_return {-1};              // return flag, then function value, in the routine frame; -1 until needed
+        int loop_returns {0};              // return statements compiled inside for loop routines so far
+
+        int level_diff(id_table_entry* entry);         // static levels between the current scope and entry
+        int new_temp();                                 // reserve a word in the current frame for a temporary value
+        void release_temp();                            // release the temporary reserved last
+        void reserve_locals(int params);                // INC over the locals of the block, after its parameters
+        bool starts_expr();                             // can the current token start an expression?
+        void open_loop();                               // new exit label for a loop
+        void close_loop();                              // place the exit label of the innermost loop here
+        void return_from_loop();                        // return from a routine inside a for loop routine
+        lille_type load(id_table_entry* entry);         // push the value of a variable, parameter or constant
+        void store(id_table_entry* entry, token* tok);  // pop the top of the stack into a variable or ref parameter
+        lille_type call(id_table_entry* routine);       // MST, actual parameters (if any), CAL
+        void argument(id_table_entry* routine, int n);  // nth actual parameter of a call
+
+        bool folding {false};                           // evaluate constant expressions at compile time?
+        bool inline_for {false};                        // compile for loops in line rather than as routines?
+        vector<int> inline_scopes;                      // scope levels of the enclosing inline for loops
+        vector<pair<id_table_entry*, code_gen::opr_code>> predefined;   // predefined functions and their conversions
+        bool fold(int left, lille_type& ty, lille_type right_ty, code_gen::opr_code op);
+        bool fold(int operand, lille_type& ty, code_gen::opr_code op);
+        bool fold_call(int start, int args, id_table_entry* routine);
+        bool inline_calls {false};                      // compile calls of small routines in line?
+        static const int inline_threshold = 12;         // instructions in the largest routine compiled in line unasked
+        bool inlinable(id_table_entry* routine);        // can a call of the routine be compiled in line?
+        void inline_call(id_table_entry* routine);      // copy the statements of the routine in place of CAL
+
 public:
 	bool eof_flag;
 	//boolean flag for if the parser reaches the eof marker.
 
-	parser(scanner* s, error_handler* e, id_table* i);
+	parser(scanner* s, error_handler* e, id_table* i, code_gen* c);
+	void set_constant_folding(bool on);	// Evaluate expressions whose operands are constants at compile time.
+	void set_inline_for_loops(bool on);	// Compile for loops in the frame of the enclosing block.
+	void set_inline_calls(bool on);		// Compile calls of small routines in line.
 
         void program();
 	void prog();
-	void define_function(string name, lille_type x, lille_type y);
-	void block();
+	void define_function(string name, lille_type x, lille_type y, code_gen::opr_code conversion, string_view comment);
+	void block(id_table_entry* routine);
 	vector<token*> identList();
 	void decl();
 	lille_type type();
-	void paramList();
-	void param();
-	void paramKind();
+	void paramList(id_table_entry* routine);
+	void param(id_table_entry* routine);
+	lille_kind paramKind();
 
 	void statementList();
 	void statement();
@@ -56,17 +93,18 @@ public:
 	void ifStatement();
 	void whileStatement();
 	void forStatement();
+	void inlineForStatement();
 	void loopStatement();
-	void range();
+	void range(bool reverse);
 
-	void expr();
-	void simpleExpr();
-	void relOp();
-	void expr2();
-	void term();
+	lille_type expr();
+	lille_type simpleExpr();
+	code_gen::opr_code relOp();
+	lille_type expr2();
+	lille_type term();
 
-	void factor();
-	void primary();
+	lille_type factor();
+	lille_type primary();
 
 };
 
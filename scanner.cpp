@@ -10,14 +10,19 @@
 #include <fstream>
 #include <filesystem>
 #include <string>
+#include <string_view>
 #include <cctype>
 #include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <array>
 
 #include "symbol.h"
 #include "error_handler.h"
 #include "token.h"
 #include "scanner.h"
 #include "lille_exception.h"
+#include "atom_table.h"
 
 using namespace std;
 
@@ -28,16 +33,21 @@ scanner::scanner()
 	line_number = 0;
 	eoln_flag = true;	// assume end of line is true before reading anything from the input buffer.
 	eof_flag = false;
-	input_buffer = "";
+	line_start = nullptr;
+	line_end = nullptr;
+	next_line = nullptr;
+	last_line_read = false;
 	next_char = end_marker;
-	current_symbol = new symbol();
-	current_token = new token();
+	current_symbol = symbol();
+	current_token = tokens.allocate();
 	current_line_number = 0;
 	current_pos_on_line = 0;
+	current_token_start = nullptr;
 	current_integer_value = 0;
 	current_real_value = 0.0;
 	current_string_value = "";
 	current_identifier_name = "";	
+	current_identifier_atom = atom_table::no_atom;
 	error = NULL;		// specified by public constructor
 	id_tab = NULL;		// specified by public constructor
         recovering = false;
@@ -50,207 +60,222 @@ scanner::scanner(string source_filename, id_table* id_t, error_handler* e) : sca
 	id_tab = id_t;
 	error = e;
 	if (filesystem::exists(source_filename))		// Check file exists
-		source_file.open(source_filename);          // Open default file for reading.
+		source.load(source_filename);				// Map the whole file into memory.
 	else
 	{
 		cerr << "Source code file not found." << endl;
 		throw lille_exception("Source code file not found.");
 	}
+	if (error != NULL)
+		error->set_source(&source);					// The listing is generated from the same copy of the source.
+	next_line = source.begin();
 	get_line();
 }
 
 
-int error_message(symbol::symbol_type s)
+struct expected_symbol_entry {
+	symbol::symbol_type sym;	// Symbol the scanner was told must come next.
+	lille_error err;				// Error reported when it does not.
+};
+
+
+constexpr expected_symbol_entry expected_symbol_errors[] = {
+	{symbol::identifier, lille_error::expected_identifier},
+	{symbol::strng, lille_error::expected_string},
+	{symbol::real_num, lille_error::expected_real_num},
+	{symbol::integer, lille_error::expected_integer},
+	{symbol::end_of_program, lille_error::expected_end_of_program},
+	{symbol::semicolon_sym, lille_error::expected_semicolon_sym},
+	{symbol::colon_sym, lille_error::expected_colon_sym},
+	{symbol::comma_sym, lille_error::expected_comma_sym},
+	{symbol::equals_sym, lille_error::expected_equals_sym},
+	{symbol::not_equals_sym, lille_error::expected_not_equals_sym},
+	{symbol::less_than_sym, lille_error::expected_less_than_sym},
+	{symbol::greater_than_sym, lille_error::expected_greater_than_sym},
+	{symbol::less_or_equal_sym, lille_error::expected_less_or_equal_sym},
+	{symbol::greater_or_equal_sym, lille_error::expected_greater_or_equal_sym},
+	{symbol::plus_sym, lille_error::expected_plus_sym},
+	{symbol::minus_sym, lille_error::expected_minus_sym},
+	{symbol::slash_sym, lille_error::expected_slash_sym},
+	{symbol::asterisk_sym, lille_error::expected_asterisk_sym},
+	{symbol::power_sym, lille_error::expected_power_sym},
+	{symbol::ampersand_sym, lille_error::expected_ampersand_sym},
+	{symbol::left_paren_sym, lille_error::expected_left_paren_sym},
+	{symbol::right_paren_sym, lille_error::expected_right_paren_sym},
+	{symbol::range_sym, lille_error::expected_range_sym},
+	{symbol::becomes_sym, lille_error::expected_becomes_sym},
+	{symbol::and_sym, lille_error::expected_and_sym},
+	{symbol::begin_sym, lille_error::expected_begin_sym},
+	{symbol::boolean_sym, lille_error::expected_boolean_sym},
+	{symbol::constant_sym, lille_error::expected_constant_sym},
+	{symbol::else_sym, lille_error::expected_else_sym},
+	{symbol::elsif_sym, lille_error::expected_elsif_sym},
+	{symbol::end_sym, lille_error::expected_end_sym},
+	{symbol::eof_sym, lille_error::expected_eof_sym},
+	{symbol::exit_sym, lille_error::expected_exit_sym},
+	{symbol::false_sym, lille_error::expected_false_sym},
+	{symbol::for_sym, lille_error::expected_for_sym},
+	{symbol::function_sym, lille_error::expected_function_sym},
+	{symbol::if_sym, lille_error::expected_if_sym},
+	{symbol::in_sym, lille_error::expected_in_sym},
+	{symbol::integer_sym, lille_error::expected_integer_sym},
+	{symbol::is_sym, lille_error::expected_is_sym},
+	{symbol::loop_sym, lille_error::expected_loop_sym},
+	{symbol::not_sym, lille_error::expected_not_sym},
+	{symbol::null_sym, lille_error::expected_null_sym},
+	{symbol::odd_sym, lille_error::expected_odd_sym},
+	{symbol::or_sym, lille_error::expected_or_sym},
+	{symbol::pragma_sym, lille_error::expected_pragma_sym},
+	{symbol::procedure_sym, lille_error::expected_procedure_sym},
+	{symbol::program_sym, lille_error::expected_program_sym},
+	{symbol::read_sym, lille_error::expected_read_sym},
+	{symbol::real_sym, lille_error::expected_real_sym},
+	{symbol::ref_sym, lille_error::expected_ref_sym},
+	{symbol::return_sym, lille_error::expected_return_sym},
+	{symbol::reverse_sym, lille_error::expected_reverse_sym},
+	{symbol::string_sym, lille_error::expected_string_sym},
+	{symbol::then_sym, lille_error::expected_then_sym},
+	{symbol::true_sym, lille_error::expected_true_sym},
+	{symbol::value_sym, lille_error::expected_value_sym},
+	{symbol::when_sym, lille_error::expected_when_sym},
+	{symbol::while_sym, lille_error::expected_while_sym},
+	{symbol::write_sym, lille_error::expected_write_sym},
+	{symbol::writeln_sym, lille_error::expected_writeln_sym},
+};
+
+
+constexpr array<lille_error, symbol::invalid_sym + 1> expected_symbol_error = []
+// Error reported for each symbol that must_be() can insist on, indexed by symbol. Symbols that are never expected
+// map to lille_error::none.
+{
+	array<lille_error, symbol::invalid_sym + 1> errors {};
+	errors.fill(lille_error::none);
+	for (const expected_symbol_entry& e : expected_symbol_errors)
+		errors[e.sym] = e.err;
+	return errors;
+}();
+
+
+constexpr bool expected_symbol_errors_unique()
+// True if no symbol has been given two errors.
+{
+	for (size_t i = 0; i < size(expected_symbol_errors); i++)
+		for (size_t j = i + 1; j < size(expected_symbol_errors); j++)
+			if (expected_symbol_errors[i].sym == expected_symbol_errors[j].sym)
+				return false;
+	return true;
+}
+
+static_assert(expected_symbol_errors_unique(), "Each symbol may have only one \"expected\" error.");
+
+
+lille_error error_message(symbol::symbol_type s)
 // Error message associated with symbol s in scanner. This is used so that we have consistency in the error message returned.
 {
-	switch (s) {
-	case symbol::identifier:
-		return 0;
-		break;
-	case symbol::strng:
-		return 1;
-		break;
-	case symbol::real_num:
-		return 2;
-		break;
-	case symbol::integer:
-		return 3;
-		break;
-	case symbol::end_of_program:
-		return 4;
-		break;
-	case symbol::semicolon_sym:
-		return 5;
-		break;
-	case symbol::colon_sym:
-		return 6;
-		break;
-	case symbol::comma_sym:
-		return 7;
-		break;
-	case symbol::equals_sym:
-		return 8;
-		break;
-	case symbol::not_equals_sym:
-		return 9;
-		break;
-	case symbol::less_than_sym:
-		return 10;
-		break;
-	case symbol::greater_than_sym:
-		return 11;
-		break;
-	case symbol::less_or_equal_sym:
-		return 12;
-		break;
-	case symbol::greater_or_equal_sym:
-		return 13;
-		break;
-	case symbol::plus_sym:
-		return 14;
-		break;
-	case symbol::minus_sym:
-		return 15;
-		break;
-	case symbol::slash_sym:
-		return 16;
-		break;
-	case symbol::asterisk_sym:
-		return 17;
-		break;
-	case symbol::power_sym:
-		return 18;
-		break;
-	case symbol::ampersand_sym:
-		return 19;
-		break;
-	case symbol::left_paren_sym:
-		return 20;
-		break;
-	case symbol::right_paren_sym:
-		return 21;
-		break;
-	case symbol::range_sym:
-		return 22;
-		break;
-	case symbol::becomes_sym:
-		return 23;
-		break;
-	case symbol::and_sym:
-		return 24;
-		break;
-	case symbol::begin_sym:
-		return 25;
-		break;
-	case symbol::boolean_sym:
-		return 26;
-		break;
-	case symbol::constant_sym:
-		return 27;
-		break;
-	case symbol::else_sym:
-		return 28;
-		break;
-	case symbol::elsif_sym:
-		return 29;
-		break;
-	case symbol::end_sym:
-		return 30;
-		break;
-	case symbol::eof_sym:
-		return 31;
-		break;
-	case symbol::exit_sym:
-		return 32;
-		break;
-	case symbol::false_sym:
-		return 33;
-		break;
-	case symbol::for_sym:
-		return 34;
-		break;
-	case symbol::function_sym:
-		return 35;
-		break;
-	case symbol::if_sym:
-		return 36;
-		break;
-	case symbol::in_sym:
-		return 37;
-		break;
-	case symbol::integer_sym:
-		return 38;
-		break;
-	case symbol::is_sym:
-		return 39;
-		break;
-	case symbol::loop_sym:
-		return 40;
-		break;
-	case symbol::not_sym:
-		return 41;
-		break;
-	case symbol::null_sym:
-		return 42;
-		break;
-	case symbol::odd_sym:
-		return 43;
-		break;
-	case symbol::or_sym:
-		return 44;
-		break;
-	case symbol::pragma_sym:
-		return 45;
-		break;
-	case symbol::procedure_sym:
-		return 46;
-		break;
-	case symbol::program_sym:
-		return 47;
-		break;
-	case symbol::read_sym:
-		return 48;
-		break;
-	case symbol::real_sym:
-		return 49;
-		break;
-	case symbol::ref_sym:
-		return 50;
-		break;
-	case symbol::return_sym:
-		return 51;
-		break;
-	case symbol::reverse_sym:
-		return 52;
-		break;
-	case symbol::string_sym:
-		return 53;
-		break;
-	case symbol::then_sym:
-		return 54;
-		break;
-	case symbol::true_sym:
-		return 55;
-		break;
-	case symbol::value_sym:
-		return 56;
-		break;
-	case symbol::when_sym:
-		return 57;
-		break;
-	case symbol::while_sym:
-		return 58;
-		break;
-	case symbol::write_sym:
-		return 59;
-		break;
-	case symbol::writeln_sym:
-		return 60;
-		break;
-	default:
+	if (expected_symbol_error[s] == lille_error::none)
 		throw lille_exception("Unexpected symbol passed to Error_Message inside Scanner.");
-		break;
+	return expected_symbol_error[s];
+}
+
+
+struct reserved_word_entry {
+	string_view name;									// Reserved word in upper case. Empty for an unused slot.
+	symbol::symbol_type sym {symbol::identifier};		// Symbol returned by the scanner for the reserved word.
+};
+
+
+constexpr reserved_word_entry reserved_words[] = {
+	{"AND", symbol::and_sym},
+	{"BEGIN", symbol::begin_sym},
+	{"BOOLEAN", symbol::boolean_sym},
+	{"CONSTANT", symbol::constant_sym},
+	{"ELSE", symbol::else_sym},
+	{"ELSIF", symbol::elsif_sym},
+	{"END", symbol::end_sym},
+	{"EOF", symbol::eof_sym},
+	{"EXIT", symbol::exit_sym},
+	{"FALSE", symbol::false_sym},
+	{"FOR", symbol::for_sym},
+	{"FUNCTION", symbol::function_sym},
+	{"IF", symbol::if_sym},
+	{"IN", symbol::in_sym},
+	{"INTEGER", symbol::integer_sym},
+	{"IS", symbol::is_sym},
+	{"LOOP", symbol::loop_sym},
+	{"NOT", symbol::not_sym},
+	{"NULL", symbol::null_sym},
+	{"ODD", symbol::odd_sym},
+	{"OR", symbol::or_sym},
+	{"PRAGMA", symbol::pragma_sym},
+	{"PROCEDURE", symbol::procedure_sym},
+	{"PROGRAM", symbol::program_sym},
+	{"READ", symbol::read_sym},
+	{"REAL", symbol::real_sym},
+	{"REF", symbol::ref_sym},
+	{"RETURN", symbol::return_sym},
+	{"REVERSE", symbol::reverse_sym},
+	{"STRING", symbol::string_sym},
+	{"THEN", symbol::then_sym},
+	{"TRUE", symbol::true_sym},
+	{"VALUE", symbol::value_sym},
+	{"WHEN", symbol::when_sym},
+	{"WRITE", symbol::write_sym},
+	{"WRITELN", symbol::writeln_sym},
+	{"WHILE", symbol::while_sym},
+};
+
+
+constexpr size_t reserved_word_slots = 64;
+constexpr size_t shortest_reserved_word = 2;
+constexpr size_t longest_reserved_word = 9;
+
+
+constexpr size_t reserved_word_hash(string_view s)
+// Perfect hash over the reserved words above: every reserved word lands in its own slot, so a single probe followed
+// by one string comparison decides whether s is a reserved word. s must be at least shortest_reserved_word long.
+{
+	return (17 * s.length() + 7 * (unsigned char)(s[0]) + 31 * (unsigned char)(s[1])
+			+ 12 * (unsigned char)(s[s.length() - 1])) % reserved_word_slots;
+}
+
+
+struct reserved_word_table {
+	reserved_word_entry slot[reserved_word_slots];
+	bool collision {false};
+};
+
+
+constexpr reserved_word_table build_reserved_word_table()
+// Place each reserved word in the slot given by reserved_word_hash(), noting any collision.
+{
+	reserved_word_table table;
+
+	for (const reserved_word_entry& w : reserved_words)
+	{
+		reserved_word_entry& slot = table.slot[reserved_word_hash(w.name)];
+		if ((!slot.name.empty()) or (w.name.length() < shortest_reserved_word) or (w.name.length() > longest_reserved_word))
+			table.collision = true;
+		slot = w;
 	}
+	return table;
+}
+
+
+constexpr reserved_word_table reserved_word_map = build_reserved_word_table();
+static_assert(!reserved_word_map.collision, "reserved_word_hash() is no longer a perfect hash over the reserved words.");
+
+
+symbol::symbol_type reserved_word(const string& s)
+// Symbol for the upper case word s: the reserved word symbol if s is one, otherwise symbol::identifier.
+{
+	if ((s.length() < shortest_reserved_word) or (s.length() > longest_reserved_word))
+		return symbol::identifier;
+
+	const reserved_word_entry& entry = reserved_word_map.slot[reserved_word_hash(s)];
+	if (entry.name == s)
+		return entry.sym;
+	else
+		return symbol::identifier;
 }
 
 
@@ -258,10 +283,10 @@ void scanner::get_char()
 {
 	// gets the next character from the input stream. Checks for end of line and end of file.
 
-	if ((pos_on_line + 1) < input_buffer.length())
+	if ((line_start + pos_on_line + 1) < line_end)
 	{
 		pos_on_line++;
-		next_char = input_buffer.at(pos_on_line);
+		next_char = line_start[pos_on_line];
 		eoln_flag = false;
 	}
 	else
@@ -272,30 +297,44 @@ void scanner::get_char()
 char scanner::following_char()
 {
 	// return the character after next_char;
-	//if (pos_on_line < (input_buffer.length()-1))
-	if ((!eof_flag) and ((pos_on_line + 1) < input_buffer.length()))
-		return input_buffer.at(pos_on_line + 1);
+	if ((!eof_flag) and ((line_start + pos_on_line + 1) < line_end))
+		return line_start[pos_on_line + 1];
 	else
 		return end_marker;;
 }
 
 
 void scanner::get_line()
+// Move to the next line of the source text. No characters are copied; line_start and line_end delimit the line
+// within the source buffer. A final newline yields one last empty line, exactly as getline() on a stream did.
 {
-	if (!source_file.eof())
+	if (!last_line_read)
 	{
-		getline(source_file, input_buffer);
+		const char* newline = static_cast<const char*>(memchr(next_line, '\n', source.end() - next_line));
+		line_start = next_line;
+		if (newline == nullptr)
+		{
+			line_end = source.end();
+			next_line = source.end();
+			last_line_read = true;
+		}
+		else
+		{
+			line_end = newline;
+			next_line = newline + 1;
+		}
 		line_number++;
 	}
 	else
 	{
 		eof_flag = true;
-		input_buffer = "";
+		line_start = source.end();
+		line_end = source.end();
 	}
 
 	if (debugging)
 	{
-		cout << "In GET_LINE " << line_number << ":  >" << input_buffer << "<" << endl;
+		cout << "In GET_LINE " << line_number << ":  >" << string(line_start, line_end) << "<" << endl;
 	}
 }
 
@@ -311,6 +350,19 @@ void scanner::fill_buffer()
 
 
 
+string_view scanner::token_text(const string& s, const char* from)
+// Text for a string token whose value is s and whose text starts at from in the source buffer. Usually s is spelt
+// exactly as in the source, so the token simply views the source buffer. Strings containing doubled quotes differ
+// from the source, so a copy of s is kept in the token arena instead.
+{
+	if (memcmp(from, s.data(), s.length()) == 0)
+		return string_view(from, s.length());
+	else
+		return tokens.keep_text(s);
+}
+
+
+
 token* scanner::get_token()
 // Get the current token from the input stream. It is held in the private variable current_token.
 {
@@ -329,10 +381,11 @@ token* scanner::get_token()
 	}
 
 	// initialize variables to record token identified and its current location in the source file;
-	current_symbol = new symbol(symbol::end_of_program);	// This is the token returned if at end of file.
+	current_symbol = symbol(symbol::end_of_program);	// This is the token returned if at end of file.
 
 	current_line_number = line_number;
 	current_pos_on_line = pos_on_line;
+	current_token_start = line_start + pos_on_line;
 
 
 	if (!eof_flag)	// If not at end of file
@@ -344,35 +397,35 @@ token* scanner::get_token()
 		else
 			scan_special_symbol();
 
-		switch (current_symbol->get_sym())
+		switch (current_symbol.get_sym())
 		{
 		case symbol::identifier:
-			current_token = new token(new symbol(symbol::identifier), current_line_number, current_pos_on_line);
-			current_token->set_identifier_value(current_identifier_name);
+			current_token = tokens.allocate(symbol(symbol::identifier), current_line_number, current_pos_on_line);
+			current_token->set_identifier_atom(current_identifier_atom);
 			break;
 		case symbol::strng:
-			current_token = new token(new symbol(symbol::strng), current_line_number, current_pos_on_line);
-			current_token->set_string_value(current_string_value);
+			current_token = tokens.allocate(symbol(symbol::strng), current_line_number, current_pos_on_line);
+			current_token->set_string_value(token_text(current_string_value, current_token_start + 1));
 			break;
 		case symbol::integer:
-			current_token = new token(new symbol(symbol::integer), current_line_number, current_pos_on_line);
+			current_token = tokens.allocate(symbol(symbol::integer), current_line_number, current_pos_on_line);
 			current_token->set_integer_value(current_integer_value);
 			break;
 		case symbol::real_num:
-			current_token = new token(new symbol(symbol::real_num), current_line_number, current_pos_on_line);
+			current_token = tokens.allocate(symbol(symbol::real_num), current_line_number, current_pos_on_line);
 			current_token->set_real_value(current_real_value);
 			break;
 		case symbol::pragma_sym:		// pragmas are handled by the scanner not the parser
 			parse_pragma();				// pragma can appear anywhere in the code.
 			break;
 		default:
-			current_token = new token(current_symbol, current_line_number, current_pos_on_line);
+			current_token = tokens.allocate(current_symbol, current_line_number, current_pos_on_line);
 		}
 	}
 	else
 	{
 		// At eof. Set token to end_of_program to indicate end of input.
-		current_token = new token(new symbol(symbol::end_of_program), line_number, pos_on_line);
+		current_token = tokens.allocate(symbol(symbol::end_of_program), line_number, pos_on_line);
 			// This is the token returned if at end of file.
 			// The parser needs to process this to make sure that
 			// there is no extraneous text after the end of the
@@ -393,7 +446,7 @@ token* scanner::get_token()
 // line in the source file. 2 adjacent double quote marks are interpreted as a single double quote character within the string.
 void scanner::scan_string()
 { 
-   current_symbol = new symbol(symbol::strng);
+   current_symbol = symbol(symbol::strng);
    current_string_value = "";
    bool isClosed = false;
    
@@ -425,7 +478,7 @@ void scanner::scan_string()
    // if the string is never closed, return an error.
    if(!isClosed)
    {
-      error->flag(current_line_number, current_pos_on_line, 60);
+      error->flag(current_line_number, current_pos_on_line, lille_error::unterminated_string);
    }
 }
 
@@ -451,84 +504,11 @@ void scanner::scan_alpha()
 		get_char();
 	}
 	if (malformed_ident or (current_identifier_name.at(current_identifier_name.length() - 1)) == '_')
-		error->flag(current_line_number, current_pos_on_line, 61); 		// Illegal underscore in identifier.
+		error->flag(current_line_number, current_pos_on_line, lille_error::illegal_underscore); 		// Illegal underscore in identifier.
 	// check to see if the string matches an a reserved word
-	if (current_identifier_name == "AND")
-		current_symbol = new symbol(symbol::and_sym);
-	else if (current_identifier_name == "BEGIN")
-		current_symbol = new symbol(symbol::begin_sym);
-	else if (current_identifier_name == "BOOLEAN")
-		current_symbol = new symbol(symbol::boolean_sym);
-	else if (current_identifier_name == "CONSTANT")
-		current_symbol = new symbol(symbol::constant_sym);
-	else if (current_identifier_name == "ELSE")
-		current_symbol = new symbol(symbol::else_sym);
-	else if (current_identifier_name == "ELSIF")
-		current_symbol = new symbol(symbol::elsif_sym);
-	else if (current_identifier_name == "END")
-		current_symbol = new symbol(symbol::end_sym);
-	else if (current_identifier_name == "EOF")
-		current_symbol = new symbol(symbol::eof_sym);
-	else if (current_identifier_name == "EXIT")
-		current_symbol = new symbol(symbol::exit_sym);
-	else if (current_identifier_name == "FALSE")
-		current_symbol = new symbol(symbol::false_sym);
-	else if (current_identifier_name == "FOR")
-		current_symbol = new symbol(symbol::for_sym);
-	else if (current_identifier_name == "FUNCTION")
-		current_symbol = new symbol(symbol::function_sym);
-	else if (current_identifier_name == "IF")
-		current_symbol = new symbol(symbol::if_sym);
-	else if (current_identifier_name == "IN")
-		current_symbol = new symbol(symbol::in_sym);
-	else if (current_identifier_name == "INTEGER")
-		current_symbol = new symbol(symbol::integer_sym);
-	else if (current_identifier_name == "IS")
-		current_symbol = new symbol(symbol::is_sym);
-	else if (current_identifier_name == "LOOP")
-		current_symbol = new symbol(symbol::loop_sym);
-	else if (current_identifier_name == "NOT")
-		current_symbol = new symbol(symbol::not_sym);
-	else if (current_identifier_name == "NULL")
-		current_symbol = new symbol(symbol::null_sym);
-	else if (current_identifier_name == "ODD")
-		current_symbol = new symbol(symbol::odd_sym);
-	else if (current_identifier_name == "OR")
-		current_symbol = new symbol(symbol::or_sym);
-	else if (current_identifier_name == "PRAGMA")
-		current_symbol = new symbol(symbol::pragma_sym);
-	else if (current_identifier_name == "PROCEDURE")
-		current_symbol = new symbol(symbol::procedure_sym);
-	else if (current_identifier_name == "PROGRAM")
-		current_symbol = new symbol(symbol::program_sym);
-	else if (current_identifier_name == "READ")
-		current_symbol = new symbol(symbol::read_sym);
-	else if (current_identifier_name == "REAL")
-		current_symbol = new symbol(symbol::real_sym);
-	else if (current_identifier_name == "REF")
-		current_symbol = new symbol(symbol::ref_sym);
-	else if (current_identifier_name == "RETURN")
-		current_symbol = new symbol(symbol::return_sym);
-	else if (current_identifier_name == "REVERSE")
-		current_symbol = new symbol(symbol::reverse_sym);
-	else if (current_identifier_name == "STRING")
-		current_symbol = new symbol(symbol::string_sym);
-	else if (current_identifier_name == "THEN")
-		current_symbol = new symbol(symbol::then_sym);
-	else if (current_identifier_name == "TRUE")
-		current_symbol = new symbol(symbol::true_sym);
-	else if (current_identifier_name == "VALUE")
-		current_symbol = new symbol(symbol::value_sym);
-	else if (current_identifier_name == "WHEN")
-		current_symbol = new symbol(symbol::when_sym);
-	else if (current_identifier_name == "WRITE")
-		current_symbol = new symbol(symbol::write_sym);
-	else if (current_identifier_name == "WRITELN")
-		current_symbol = new symbol(symbol::writeln_sym);
-	else if (current_identifier_name == "WHILE")
-		current_symbol = new symbol(symbol::while_sym);
-	else
-		current_symbol = new symbol(symbol::identifier);
+	current_symbol = symbol(reserved_word(current_identifier_name));
+	if (current_symbol.get_sym() == symbol::identifier)
+		current_identifier_atom = atom_table::intern(current_identifier_name);
 }
 
 //Scans in a token beginning with a digit.
@@ -556,18 +536,18 @@ void scanner::scan_digit()
    }
    catch(...)
    {
-      error->flag(current_line_number, current_pos_on_line, 62);
+      error->flag(current_line_number, current_pos_on_line, lille_error::number_too_large);
    }
 
    if((next_char == '.') && (following_char() != '.')) //makes sure there is no range symbol
    {
-      current_symbol = new symbol(symbol::real_num);
+      current_symbol = symbol(symbol::real_num);
       num = "";
       get_char();
 
       if(!isdigit(next_char))
       {
-         error->flag(current_line_number, current_pos_on_line, 63);
+         error->flag(current_line_number, current_pos_on_line, lille_error::no_digits_after_dot);
       }
       else
       {
@@ -586,7 +566,7 @@ void scanner::scan_digit()
          }
          catch(...)
          {
-            error->flag(current_line_number, current_pos_on_line, 63);
+            error->flag(current_line_number, current_pos_on_line, lille_error::no_digits_after_dot);
          }
 
       }
@@ -602,7 +582,7 @@ void scanner::scan_digit()
          }
          if(!isdigit(next_char))
          {
-            error->flag(current_line_number, current_pos_on_line, 64);
+            error->flag(current_line_number, current_pos_on_line, lille_error::no_digits_in_exponent);
          }
          while(isdigit(next_char))
          {
@@ -616,7 +596,7 @@ void scanner::scan_digit()
          }
          catch(...)
          {
-            error->flag(current_line_number, current_pos_on_line, 65);
+            error->flag(current_line_number, current_pos_on_line, lille_error::exponent_too_long);
          }
          try
          {
@@ -627,13 +607,13 @@ void scanner::scan_digit()
          }
          catch(...)
          {
-            error->flag(current_line_number, current_pos_on_line, 66);
+            error->flag(current_line_number, current_pos_on_line, lille_error::malformed_real);
          }
       }
    }
    else
    {
-      current_symbol = new symbol(symbol::integer);
+      current_symbol = symbol(symbol::integer);
       num = "";
 
       if(next_char == 'E' || next_char == 'e')
@@ -643,12 +623,12 @@ void scanner::scan_digit()
          if(sign == '-' || sign == '+')
             if(sign == '-')
             {
-               error->flag(current_line_number, current_pos_on_line, 67);
+               error->flag(current_line_number, current_pos_on_line, lille_error::negative_integer_exponent);
             }
             get_char();
          if(!isdigit(next_char))
          {
-            error->flag(current_line_number, current_pos_on_line, 64);
+            error->flag(current_line_number, current_pos_on_line, lille_error::no_digits_in_exponent);
          }
          while(isdigit(next_char))
          {
@@ -662,7 +642,7 @@ void scanner::scan_digit()
          }
          catch(...)
          {
-            error->flag(current_line_number, current_pos_on_line, 65);
+            error->flag(current_line_number, current_pos_on_line, lille_error::exponent_too_long);
          }
          try
          {
@@ -673,7 +653,7 @@ void scanner::scan_digit()
          }
          catch(...)
          {
-            error->flag(current_line_number, current_pos_on_line, 66);
+            error->flag(current_line_number, current_pos_on_line, lille_error::malformed_real);
          }
       }
    }
@@ -688,90 +668,90 @@ void scanner::scan_special_symbol()
 	case ':':	// BECOMES or a COLON
 		if (following_char() == '=')
 		{
-			current_symbol = new symbol(symbol::becomes_sym);
+			current_symbol = symbol(symbol::becomes_sym);
 			get_char();
 		}
 		else
-			current_symbol = new symbol(symbol::colon_sym);
+			current_symbol = symbol(symbol::colon_sym);
 		break;
 	case '<':	// LESS THAN, LESS OR EQUAL, or NOT EQUAL
 		if (following_char() == '=')
 		{
-			current_symbol = new symbol(symbol::less_or_equal_sym);
+			current_symbol = symbol(symbol::less_or_equal_sym);
 			get_char();
 		}
 		else if (following_char() == '>')
 		{
-			current_symbol = new symbol(symbol::not_equals_sym);
+			current_symbol = symbol(symbol::not_equals_sym);
 			get_char();
 		}
 		else
-			current_symbol = new symbol(symbol::less_than_sym);
+			current_symbol = symbol(symbol::less_than_sym);
 		break;
 	case '>':	// GREATER THAN, or GREATER OR EQUAL
 		if (following_char() == '=')
 		{
-			current_symbol = new symbol(symbol::greater_or_equal_sym);
+			current_symbol = symbol(symbol::greater_or_equal_sym);
 			get_char();
 		}
 		else
-			current_symbol = new symbol(symbol::greater_than_sym);
+			current_symbol = symbol(symbol::greater_than_sym);
 		break;
 	case '*':	// ASTERISK or POWER symbol
 		if (following_char() == '*')
 		{
-			current_symbol = new symbol(symbol::power_sym);
+			current_symbol = symbol(symbol::power_sym);
 			get_char();
 		}
 		else
-			current_symbol = new symbol(symbol::asterisk_sym);
+			current_symbol = symbol(symbol::asterisk_sym);
 		break;
 	case '.':	// RANGE symbol
 		if (following_char() == '.')
 		{
-			current_symbol = new symbol(symbol::range_sym);
+			current_symbol = symbol(symbol::range_sym);
 			get_char();
 		}
 		else
 		{
 			// illegal symbol
-			current_symbol = new symbol(symbol::nul);
-			error->flag(current_line_number, current_pos_on_line, 22);	// Expected a range token.
+			current_symbol = symbol(symbol::nul);
+			error->flag(current_line_number, current_pos_on_line, lille_error::expected_range_sym);	// Expected a range token.
 		}
 		break;
 	case '"':	// Start of a string
 		scan_string();
 		break;
 	case '&':
-		current_symbol = new symbol(symbol::ampersand_sym);
+		current_symbol = symbol(symbol::ampersand_sym);
 		break;
 	case '/':
-		current_symbol = new symbol(symbol::slash_sym);
+		current_symbol = symbol(symbol::slash_sym);
 		break;
 	case ';':
-		current_symbol = new symbol(symbol::semicolon_sym);
+		current_symbol = symbol(symbol::semicolon_sym);
 		break;
 	case '(':
-		current_symbol = new symbol(symbol::left_paren_sym);
+		current_symbol = symbol(symbol::left_paren_sym);
 		break;
 	case ')':
-		current_symbol = new symbol(symbol::right_paren_sym);
+		current_symbol = symbol(symbol::right_paren_sym);
 		break;
 	case ',':
-		current_symbol = new symbol(symbol::comma_sym);
+		current_symbol = symbol(symbol::comma_sym);
 		break;
 	case '+':
-		current_symbol = new symbol(symbol::plus_sym);
+		current_symbol = symbol(symbol::plus_sym);
 		break;
 	case '-':
-		current_symbol = new symbol(symbol::minus_sym);
+		current_symbol = symbol(symbol::minus_sym);
 		break;
 	case '=':
-		current_symbol = new symbol(symbol::equals_sym);
+		current_symbol = symbol(symbol::equals_sym);
 		break;
 	default:
-		current_symbol = new symbol(symbol::nul);
-		error->flag(current_line_number, current_pos_on_line, 74); 	// illegal character.
+		current_symbol = symbol(symbol::nul);
+		error->flag(current_line_number, current_pos_on_line, lille_error::illegal_character); 	// illegal character.
 		break;
 	}
 	get_char();	// get the next character
@@ -790,79 +770,89 @@ void scanner::parse_pragma()
 	string pragma_name = "";
 
 	get_token();	// consume the pragma keyword
-	if (current_symbol->get_sym() == symbol::identifier)
+	if (current_symbol.get_sym() == symbol::identifier)
 	{
 		pragma_name = current_identifier_name;;
 		if ((pragma_name != "ERROR_LIMIT")
 				and (pragma_name != "TRACE")
 				and (pragma_name != "UNTRACE")
-				and (pragma_name != "DEBUG"))
-			error->flag(current_line_number, current_pos_on_line, 70);		// Illegal pragma name
+				and (pragma_name != "DEBUG")
+				and (pragma_name != "INLINE"))
+			error->flag(current_line_number, current_pos_on_line, lille_error::illegal_pragma_name);		// Illegal pragma name
 	}
 	else
-		error->flag(current_line_number, current_pos_on_line, 69);  	// Malformed pragma.
+		error->flag(current_line_number, current_pos_on_line, lille_error::malformed_pragma);  	// Malformed pragma.
 	get_token();	// consume pragma name
 	// check to see if arguments are provided to the pragma
-	if (current_symbol->get_sym() == symbol::left_paren_sym)
+	if (current_symbol.get_sym() == symbol::left_paren_sym)
 		get_token();	// consume left paren
 		// C++ does not support the use of a switch statement on strings.
 	else
-		error->flag(current_line_number, current_pos_on_line, 20);	// pragmas have arguments so a left paren is expected.
+		error->flag(current_line_number, current_pos_on_line, lille_error::expected_left_paren_sym);	// pragmas have arguments so a left paren is expected.
 
 	if (pragma_name == "ERROR_LIMIT")
 	{
-		if (current_symbol->get_sym() == symbol::integer)
-        {
-			// INSERT CODE HERE
-        }
+		if (current_symbol.get_sym() == symbol::integer)
+			error->set_error_limit(current_integer_value);		// Compilation stops as soon as this many errors are found.
 		else
-			error->flag(current_line_number, current_pos_on_line, 71);	// pragma ERROR_LIMIT requires a numeric argument.
+			error->flag(current_line_number, current_pos_on_line, lille_error::error_limit_needs_number);	// pragma ERROR_LIMIT requires a numeric argument.
 	}
 	else if (pragma_name == "TRACE")
 	{
-		if (current_symbol->get_sym() == symbol::identifier)
+		if (current_symbol.get_sym() == symbol::identifier)
 			// Turn on tracing flag in the symbol table for this identifier.
 			// Do not generate an error if the identifier is not present!
 		{
             // INSERT CODE HERE
 		}
 		else
-			error->flag(current_line_number, current_pos_on_line, 72);	// pragma TRACE requires a variable name.
+			error->flag(current_line_number, current_pos_on_line, lille_error::variable_name_expected);	// pragma TRACE requires a variable name.
 	}
 	else if (pragma_name == "UNTRACE")
 	{
-		if (current_symbol->get_sym() == symbol::identifier)
+		if (current_symbol.get_sym() == symbol::identifier)
             // Turn off tracing flag in the symbol table for this identifier.
             // Do not generate an error if the identifier is not present!
         {
             // INSERT CODE HERE
         }
 		else
-			error->flag(current_line_number, current_pos_on_line, 72);	// pragma UNTRACE requires a variable name.
+			error->flag(current_line_number, current_pos_on_line, lille_error::variable_name_expected);	// pragma UNTRACE requires a variable name.
+	}
+	else if (pragma_name == "INLINE")
+	{
+		if (current_symbol.get_sym() == symbol::identifier)
+		{
+			// Compile calls of the routine in line when inlining is enabled. If the routine has not been declared
+			// yet, the request waits in the identifier table for its declaration.
+			id_tab->request_inline(current_identifier_atom);
+		}
+		else
+			error->flag(current_line_number, current_pos_on_line, lille_error::procedure_name_expected);	// pragma INLINE requires a routine name.
 	}
 	else if (pragma_name == "DEBUG")
 	{
-		if (current_symbol->get_sym() == symbol::identifier)
+		if (current_symbol.get_sym() == symbol::identifier)
 		{
 			// INSERT CODE HERE
             // pragma DEBUG requires either ON or OFF as the argument.
 		}
 		else
-			error->flag(current_line_number, current_pos_on_line, 72);	// pragma TRACE requires a variable name.
+			error->flag(current_line_number, current_pos_on_line, lille_error::variable_name_expected);	// pragma TRACE requires a variable name.
 	}
 	else
 	{
 		// Already generated an error message about an illegal pragma name
 	}
 	get_token();	// consume the argument
-	if (current_symbol->get_sym() == symbol:: right_paren_sym)
+	if (current_symbol.get_sym() == symbol:: right_paren_sym)
 		get_token();		// consume right paren
 	else
-		error->flag(current_line_number, current_pos_on_line, 21);	// Right paren expected
-	if (current_symbol->get_sym() == symbol::semicolon_sym)
+		error->flag(current_line_number, current_pos_on_line, lille_error::expected_right_paren_sym);	// Right paren expected
+	if (current_symbol.get_sym() == symbol::semicolon_sym)
 			get_token();		// consume semicolon
 	else
-		error->flag(current_line_number, current_pos_on_line, 5);	// semicolon expected
+		error->flag(current_line_number, current_pos_on_line, lille_error::expected_semicolon_sym);	// semicolon expected
 
 }
 
@@ -908,17 +898,33 @@ void scanner::must_be(symbol::symbol_type s)
 token* scanner::this_token()
 // Returns the current token, without advancing to the next token in the input stream.
 {
-	token* result = new token();
-	result = current_token;
-	return result;
+	return current_token;
+}
+
+
+string_view scanner::keep_text(string_view s)
+// Copies s into the scanner's token arena.
+{
+	return tokens.keep_text(s);
 }
 
-//Gets the current identifier name
+
+token* scanner::new_token(symbol s, int line, int pos)
+// Creates a token in the scanner's token arena.
+{
+	return tokens.allocate(s, line, pos);
+}
+
+//Gets the current identifier name. scan_alpha() has already converted it to upper case.
 string scanner::get_current_identifier_name()
 {
-   string s = current_identifier_name;
-   transform(s.begin(), s.end(), s.begin(), ::toupper);
-   return s;
+   return current_identifier_name;
+}
+
+//Gets the atom of the current identifier
+int scanner::get_current_identifier_atom()
+{
+   return current_identifier_atom;
 }
 
 
@@ -16,6 +16,8 @@
 #include "token.h"
 #include "error_handler.h"
 #include "id_table.h"
+#include "source_buffer.h"
+#include "token_arena.h"
 
 using namespace std;
 
@@ -24,8 +26,9 @@ private:
 	bool debugging {false};			// Set debugging to true to execute statement to help debug the scanner, otherwise set to false.
 
 	const char end_marker = char(7);	// BELL character. Not typically in the source file and it is a control character < SPACE
+	token_arena tokens;				// Every token created during the compilation. Released when the scanner is destroyed.
 	token* current_token;
-	ifstream source_file;			// Source file to be compiled.
+	source_buffer source;			// Source file to be compiled, held in memory in its entirety.
 	error_handler* error;			// Error handler for the scanner.
 	id_table* id_tab;
         bool recovering;
@@ -34,16 +37,21 @@ private:
 	int line_number;				// current line number
 	bool eoln_flag;					// flag to indicate of whole string (line) has been processed
 
-	string input_buffer;			// line from source file that is currently being processed
+	const char* line_start;			// first character of the line from source file that is currently being processed
+	const char* line_end;			// one past the last character of the current line (the newline is excluded)
+	const char* next_line;			// start of the line that get_line() will return next
+	bool last_line_read;			// set once the line running up to the end of the source text has been handed out
 	char next_char;					// next character to be processed
 
-	symbol* current_symbol;
+	symbol current_symbol;
 	int current_line_number;		// current line number of the start of the token we are handling
 	int current_pos_on_line;		// position on line of the start of the token we are handling
+	const char* current_token_start;	// first character of the token we are handling, within the source buffer
 	int current_integer_value;		// value if the token is an integer value
 	float current_real_value;;		// value if the token is a floating point number.
 	string current_string_value;
 	string current_identifier_name;
+	int current_identifier_atom;	// atom of current_identifier_name if the token is an identifier
 
 	void scan_string();				// scan in a string
 	void scan_alpha();				// scan in a token beginning with a letter
@@ -52,17 +60,19 @@ private:
 	void parse_pragma();			// parse the pragma identified by the scanner.
 
 	scanner();						// default constructor for the scanner.
-	void get_line();				// Get a line from the source file and store in the input buffer.
-	void get_char();				// get the next character from the input_buffer
+	void get_line();				// Advance line_start/line_end to the next line of the source text.
+	void get_char();				// get the next character from the current line
 	char following_char();			// peek at the next character on the line. Helpful for dealing with compound symbols such as :=
 	void fill_buffer();				// Call get_line() and set next_char
+	string_view token_text(const string& s, const char* from);	// View of s for a string token. See scanner.cpp.
 
 public:
     bool eof_flag;
     // Boolean flag to indicate if scanner has reached eof marker.
 
     scanner(string source_file, id_table* id_t, error_handler* e);
-    // Opens the specified source file to read tokens from.
+    // Opens the specified source file to read tokens from. The whole file is loaded (memory mapped where possible)
+    // before scanning starts.
     // Id_t is the identifier table for the compiler. It is only used by the scanner to implement the behavior
     // of pragmas.
     // E is the error handler for the scanner to use.
@@ -81,7 +91,18 @@ public:
     token* this_token();
     // Returns the current token, without advancing to the next token in the input stream.
 
+    string_view keep_text(string_view s);
+    // Copies s into the scanner's token arena, so that a token created with new_token() can refer to it.
+
+    token* new_token(symbol s, int line, int pos);
+    // Creates a token in the scanner's token arena. Like the tokens returned by get_token(), it remains valid
+    // until the scanner is destroyed at the end of compilation.
+
     string get_current_identifier_name();
+    // Returns the (upper case) name of the identifier scanned most recently.
+
+    int get_current_identifier_atom();
+    // Returns the atom of the identifier scanned most recently. See atom_table.h.
 };
 
 #endif /* SCANNER_H_ */
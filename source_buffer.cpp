@@ -0,0 +1,96 @@
+/*
+ * source_buffer.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: McHale Trotter
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "source_buffer.h"
+#include "lille_exception.h"
+
+using namespace std;
+
+
+source_buffer::source_buffer()
+// Constructor. Nothing loaded yet.
+{
+	text = "";
+	length = 0;
+	mapped = false;
+}
+
+
+source_buffer::~source_buffer()
+// Destructor. Release the mapping if one was made.
+{
+	if (mapped)
+		munmap(const_cast<char*>(text), length);
+}
+
+
+void source_buffer::load(string filename)
+// Map the whole source file into memory. Fall back to a buffered read for anything that is not a regular file.
+{
+	struct stat info;
+	int fd = open(filename.c_str(), O_RDONLY);
+
+	if (fd < 0)
+		throw lille_exception("Unable to open source file \"" + filename + "\".");
+
+	if ((fstat(fd, &info) == 0) and S_ISREG(info.st_mode) and (info.st_size > 0))
+	{
+		void* region = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (region != MAP_FAILED)
+		{
+			madvise(region, info.st_size, MADV_SEQUENTIAL);	// The scanner walks the file from front to back exactly once.
+			text = static_cast<const char*>(region);
+			length = info.st_size;
+			mapped = true;
+		}
+	}
+	close(fd);
+
+	if (!mapped)
+		read_stream(filename);
+}
+
+
+void source_buffer::read_stream(string filename)
+// Read the whole file through a buffered stream. Used for pipes and if mapping the file fails.
+{
+	ifstream in(filename, ios::binary);
+
+	if (!in)
+		throw lille_exception("Unable to read source file \"" + filename + "\".");
+	contents.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+	text = contents.data();
+	length = contents.size();
+}
+
+
+const char* source_buffer::begin()
+{
+	return text;
+}
+
+
+const char* source_buffer::end()
+{
+	return text + length;
+}
+
+
+size_t source_buffer::size()
+{
+	return length;
+}
@@ -0,0 +1,43 @@
+/*
+ * source_buffer.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: McHale Trotter
+ */
+
+#ifndef SOURCE_BUFFER_H_
+#define SOURCE_BUFFER_H_
+
+#include <string>
+#include <cstddef>
+
+#include "lille_exception.h"
+
+using namespace std;
+
+class source_buffer {
+private:
+	const char* text;				// First character of the source text.
+	size_t length;					// Number of characters in the source text.
+	bool mapped;					// True if text refers to a memory mapped region of the source file.
+	string contents;				// Holds the source text when the file cannot be mapped (pipes, character devices etc.)
+
+	void read_stream(string filename);	// Read the whole file through a buffered stream.
+
+public:
+	source_buffer();
+	~source_buffer();
+
+	source_buffer(const source_buffer&) = delete;
+	source_buffer& operator=(const source_buffer&) = delete;
+
+	void load(string filename);
+	// Make the whole of the named file available in memory. Regular files are memory mapped, anything else
+	// is read once through a buffered stream. Raises a lille_exception if the file cannot be read.
+
+	const char* begin();			// First character of the source text.
+	const char* end();				// One past the last character of the source text.
+	size_t size();					// Number of characters in the source text.
+};
+
+#endif /* SOURCE_BUFFER_H_ */
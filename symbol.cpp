@@ -8,6 +8,8 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <cctype>
 #include <cmath>
 
@@ -16,40 +18,98 @@
 using namespace std;
 
 
+// Mapping of symbol_type to a string for printing purposes. Shared by every symbol; entries are in the same
+// order as the enumerated type symbol_type.
+static constexpr string_view symbol_string[] = {
+	"Nul",						// nul
+	"Identifier",				// identifier
+	"Strng",					// strng
+	"Real_num",					// real_num
+	"Integer",					// integer
+	"End_of_program",			// end_of_program
+	"Semicolon_sym",			// semicolon_sym
+	"Comma_sym",				// comma_sym
+	"Colon_sym",				// colon_sym
+	"Equals_sym",				// equals_sym
+	"Not_equals_sym",			// not_equals_sym
+	"less_than_sym",			// less_than_sym
+	"Greater_than_sym",			// greater_than_sym
+	"Less_or_equal_sym",		// less_or_equal_sym
+	"Greater_or_equal_sym",		// greater_or_equal_sym
+	"Plus_sym",					// plus_sym
+	"Minus_sym",				// minus_sym
+	"Slash_sym",				// slash_sym
+	"Asterisk_sym",				// asterisk_sym
+	"Power_sym",				// power_sym
+	"Ampersand_sym",			// ampersand_sym
+	"Left_paren_sym",			// left_paren_sym
+	"Right_paren_sym",			// right_paren_sym
+	"Range_sym",				// range_sym
+	"Becomes_sym",				// becomes_sym
+	"And_sym",					// and_sym
+	"Begin_sym",				// begin_sym
+	"Boolean_sym",				// boolean_sym
+	"Constant_sym",				// constant_sym
+	"Else_sym",					// else_sym
+	"Elsif_sym",				// elsif_sym
+	"End_sym",					// end_sym
+	"Eof_sym",					// eof_sym
+	"Exit_sym",					// exit_sym
+	"False_sym",				// false_sym
+	"For_sym",					// for_sym
+	"Function_sym",				// function_sym
+	"If_sym",					// if_sym
+	"In_sym",					// in_sym
+	"Integer_sym",				// integer_sym
+	"Is_sym",					// is_sym
+	"Loop_sym",					// loop_sym
+	"Not_sym",					// not_sym
+	"Null_sym",					// null_sym
+	"Odd_sym",					// odd_sym
+	"Or_sym",					// or_sym
+	"Pragma_sym",				// pragma_sym
+	"Procedure_sym",			// procedure_sym
+	"Program_sym",				// program_sym
+	"Read_sym",					// read_sym
+	"Real_sym",					// real_sym
+	"Ref_sym",					// ref_sym
+	"Return_sym",				// return_sym
+	"Reverse_sym",				// reverse_sym
+	"String_sym",				// string_sym
+	"Then_sym",					// then_sym
+	"True_sym",					// true_sym
+	"Value_sym",				// value_sym
+	"When_sym",					// when_sym
+	"Write_sym",				// write_sym
+	"Writeln_sym",				// writeln_sym
+	"While_sym",				// while_sym
+	"Invalid_sym",				// invalid_sym
+};
+
+static_assert(sizeof(symbol_string) / sizeof(symbol_string[0]) == symbol::invalid_sym + 1,
+		"symbol_string must name every symbol_type.");
+static_assert(is_trivially_copyable_v<symbol>, "symbol is passed and stored by value.");
+
+
 symbol::symbol()
 {
 	sym = invalid_sym;
-	establish_symbol_map();
 }
 
 
-symbol::symbol(symbol::symbol_type s) : symbol()
+symbol::symbol(symbol::symbol_type s)
 {
 	sym = s;
 }
 
 
-symbol::symbol(const symbol& s2)
-{
-	symbol::sym = s2.sym;
-
-}
-
-
-bool symbol::operator==(const symbol& s2)
+bool symbol::operator==(const symbol& s2) const
 {
 	return (sym == s2.sym);
 }
 
 
-symbol symbol::operator=(const symbol& sym2)
-{
-	symbol::sym = sym2.sym;
-	return *this;
-}
-
-
-symbol::symbol_type symbol::get_sym()
+symbol::symbol_type symbol::get_sym() const
 {
 	return sym;
 }
@@ -61,78 +121,7 @@ void symbol::set_sym(symbol_type s)
 }
 
 
-string symbol::symtostr()
+string_view symbol::symtostr() const
 {
 	return symbol_string[sym];
 }
-
-
-void symbol::establish_symbol_map()
-{
-
-	// Set up the mapping of symbol_type to a string for printing purposes.
-
-	symbol::symbol_string[nul] = "Nul";
-	symbol::symbol_string[identifier] = "Identifier";
-	symbol::symbol_string[strng] = "Strng";
-	symbol::symbol_string[real_num] = "Real_num";
-	symbol::symbol_string[integer] = "Integer";
-	symbol::symbol_string[end_of_program] = "End_of_program";
-	symbol::symbol_string[semicolon_sym] = "Semicolon_sym";
-	symbol::symbol_string[comma_sym] = "Comma_sym";
-	symbol::symbol_string[colon_sym] = "Colon_sym";
-	symbol::symbol_string[equals_sym] = "Equals_sym";
-	symbol::symbol_string[not_equals_sym] = "Not_equals_sym";
-	symbol::symbol_string[less_than_sym] = "less_than_sym";
-	symbol::symbol_string[greater_than_sym] = "Greater_than_sym";
-	symbol::symbol_string[less_or_equal_sym] = "Less_or_equal_sym";
-	symbol::symbol_string[greater_or_equal_sym] = "Greater_or_equal_sym";
-	symbol::symbol_string[plus_sym] = "Plus_sym";
-	symbol::symbol_string[minus_sym] = "Minus_sym";
-	symbol::symbol_string[slash_sym] = "Slash_sym";
-	symbol::symbol_string[asterisk_sym] = "Asterisk_sym";
-	symbol::symbol_string[power_sym] = "Power_sym";
-	symbol::symbol_string[ampersand_sym] = "Ampersand_sym";
-	symbol::symbol_string[left_paren_sym] = "Left_paren_sym";
-	symbol::symbol_string[right_paren_sym] = "Right_paren_sym";
-	symbol::symbol_string[range_sym] = "Range_sym";
-	symbol::symbol_string[becomes_sym] = "Becomes_sym";
-	symbol::symbol_string[and_sym] = "And_sym";
-	symbol::symbol_string[begin_sym] = "Begin_sym";
-	symbol::symbol_string[boolean_sym] = "Boolean_sym";
-	symbol::symbol_string[constant_sym] = "Constant_sym";
-	symbol::symbol_string[else_sym] = "Else_sym";
-	symbol::symbol_string[elsif_sym] = "Elsif_sym";
-	symbol::symbol_string[end_sym] = "End_sym";
-	symbol::symbol_string[eof_sym] = "Eof_sym";
-	symbol::symbol_string[exit_sym] = "Exit_sym";
-	symbol::symbol_string[false_sym] = "False_sym";
-	symbol::symbol_string[for_sym] = "For_sym";
-	symbol::symbol_string[function_sym] = "Function_sym";
-	symbol::symbol_string[if_sym] = "If_sym";
-	symbol::symbol_string[in_sym] = "In_sym";
-	symbol::symbol_string[integer_sym] = "Integer_sym";
-	symbol::symbol_string[is_sym] = "Is_sym";
-	symbol::symbol_string[loop_sym] = "Loop_sym";
-	symbol::symbol_string[not_sym] = "Not_sym";
-	symbol::symbol_string[null_sym] = "Null_sym";
-	symbol::symbol_string[odd_sym] = "Odd_sym";
-	symbol::symbol_string[or_sym] = "Or_sym";
-	symbol::symbol_string[pragma_sym] = "Pragma_sym";
-	symbol::symbol_string[procedure_sym] = "Procedure_sym";
-	symbol::symbol_string[program_sym] = "Program_sym";
-	symbol::symbol_string[read_sym] = "Read_sym";
-	symbol::symbol_string[real_sym] = "Real_sym";
-	symbol::symbol_string[ref_sym] = "Ref_sym";
-	symbol::symbol_string[return_sym] = "Return_sym";
-	symbol::symbol_string[reverse_sym] = "Reverse_sym";
-	symbol::symbol_string[string_sym] = "String_sym";
-	symbol::symbol_string[then_sym] = "Then_sym";
-	symbol::symbol_string[true_sym] = "True_sym";
-	symbol::symbol_string[value_sym] = "Value_sym";
-	symbol::symbol_string[when_sym] = "When_sym";
-	symbol::symbol_string[write_sym] = "Write_sym";
-	symbol::symbol_string[writeln_sym] = "Writeln_sym";
-	symbol::symbol_string[while_sym] = "While_sym";
-	symbol::symbol_string[invalid_sym] = "Invalid_sym";
-}
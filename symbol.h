@@ -10,6 +10,7 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 
 using namespace std;
 
@@ -85,27 +86,20 @@ public:
 
 	symbol();
 	symbol(symbol_type s);
-	symbol(const symbol& s2);
+	// symbol is a small value type: it holds nothing but its symbol_type, so it is trivially copyable and is
+	// passed and stored by value. Copying and assignment are the compiler generated ones.
 
-    bool operator==(const symbol& s2);
-    symbol operator=(const symbol& sym2);
+	bool operator==(const symbol& s2) const;
 
-	symbol::symbol_type get_sym();
+	symbol::symbol_type get_sym() const;
 	void set_sym(symbol_type s);
 
-	string symtostr();
+	string_view symtostr() const;	// Name of the symbol, used to help output the symbols. Helpful for debugging.
 
 private:
 
 	symbol_type sym;
 
-	enum {arrsize = int(symbol_type::invalid_sym) + 1};
-		//string symbol_string[arrsize]; // used to help output the symbols in the enumerated type above. Helpful for debugging.
-
-	string symbol_string[arrsize];
-
-	void establish_symbol_map();
-
 }; /* class symbol */
 
 #endif /* SYMBOL_H_ */
@@ -7,10 +7,13 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
 #include "symbol.h"
 #include "token.h"
 #include "lille_exception.h"
+#include "atom_table.h"
 
 using namespace std;
 
@@ -18,64 +21,42 @@ using namespace std;
 token::token()
 // Constructor
 {
-	token::sym = new symbol(symbol::nul);
+	token::sym = symbol(symbol::nul);
 	token::line_number = 0;
 	token::pos_on_line = 0;
-	token::real_value = 0.0;
-	token::integer_value = 0;
-	token::string_value = "";
-	token::identifier_value = "";
+	token::text_length = 0;
+	token::text = nullptr;
+	if (sym.get_sym() == symbol::identifier)
+		token::atom = atom_table::no_atom;
 }
 
 
-token::token(symbol *s, int line, int pos)
+token::token(symbol s, int line, int pos)
 // Constructor
 {
 	token::sym = s;
 	token::line_number = line;
 	token::pos_on_line = pos;
-	token::real_value = 0.0;
-	token::integer_value = 0;
-	token::string_value = "";
-	token::identifier_value = "";
+	token::text_length = 0;
+	token::text = nullptr;
+	if (sym.get_sym() == symbol::identifier)
+		token::atom = atom_table::no_atom;
 }
 
 
-token::token(const token& t)
-// copy constructor
-{
-	token::sym = t.sym;
-	token::line_number = t.line_number;
-	token::pos_on_line = t.pos_on_line;
-	token::real_value = t.real_value;
-	token::integer_value = t.integer_value;
-	token::string_value = t.string_value;
-	token::identifier_value = t.identifier_value;
-}
-
-
-token& token::operator=(const token& t)
-// copy assignment
-{
-	token::sym = t.sym;
-	token::line_number = t.line_number;
-	token::pos_on_line = t.pos_on_line;
-	token::real_value = t.real_value;
-	token::integer_value = t.integer_value;
-	token::string_value = t.string_value;
-	token::identifier_value = t.identifier_value;
-	return *this;
-}
+// token is a plain value: copying is the compiler generated member-wise copy.
+static_assert(is_trivially_copyable_v<token>, "token must remain a plain value.");
+static_assert(sizeof(token) <= 24, "token should fit in 24 bytes.");
 
 
 symbol::symbol_type token::get_sym()
 // returns the symbol.
 {
-	return sym->get_sym();
+	return sym.get_sym();
 }
 
 
-symbol * token::get_symbol()
+symbol token::get_symbol()
 // returns the symbol.
 {
 	return sym;
@@ -99,7 +80,7 @@ int token::get_pos_on_line()
 float token::get_real_value()
 // returns the real only if the symbol is a real_number. Raises a lille_exceeption otherwise.
 {
-	if (sym->get_sym() == symbol::real_num)
+	if (sym.get_sym() == symbol::real_num)
 		return real_value;
 	else
 		throw lille_exception("Illegal access to real_value in token.");
@@ -109,36 +90,36 @@ float token::get_real_value()
 int token::get_integer_value()
 // returns the integer_value only if the symbol is a integer_number. Raises a lille_exceeption otherwise.
 {
-	if (sym->get_sym() == symbol::integer)
+	if (sym.get_sym() == symbol::integer)
 		return integer_value;
 	else
 		throw lille_exception("Illegal access to integer_value in token.");
 }
 
-string token::get_prog_value()
+string_view token::get_prog_value()
 {
-	if(sym->get_sym() == symbol::program_sym)
-		return prog_value;
+	if(sym.get_sym() == symbol::program_sym)
+		return string_view(text, text_length);
 	else return "";
 }
 
 
 
-string token::get_string_value()
+string_view token::get_string_value()
 // returns the string_value only if the symbol is a string. Raises a lille_exceeption otherwise.
 {
-	if (sym->get_sym() == symbol::strng)
-		return string_value;
+	if (sym.get_sym() == symbol::strng)
+		return string_view(text, text_length);
 	else
 		throw lille_exception("Illegal access to string_value in token.");
 }
 
 
-string token::get_identifier_value()
+string_view token::get_identifier_value()
 // returns the string_value only if the symbol is an identifier. Raises a lille_exceeption otherwise.
 {
-	if (sym->get_sym() == symbol::identifier)
-		return identifier_value;
+	if ((sym.get_sym() == symbol::identifier) and (atom != atom_table::no_atom))
+		return atom_table::name(atom);
 	else
 		return "";
 		//throw lille_exception("Illegal access to identifier_value in token.");
@@ -148,7 +129,7 @@ string token::get_identifier_value()
 void token::set_real_value(float f)
 // Set the real_value to f only if the token represents a real_value. Raise an exception otherwise.
 {
-	if (sym->get_sym() == symbol::real_num)
+	if (sym.get_sym() == symbol::real_num)
 		real_value = f;
 	else
 		throw lille_exception("Illegal attempt to set real_value in token");
@@ -158,34 +139,57 @@ void token::set_real_value(float f)
 void token::set_integer_value(int i)
 // Set the ingteger_value to i only if the token represents a integer_value. Raise an exception otherwise.
 {
-	if (sym->get_sym() == symbol::integer)
+	if (sym.get_sym() == symbol::integer)
 		integer_value = i;
 	else
 		throw lille_exception("Illegal attempt to set integer_value in token");
 }
 
-void token::set_prog_value(string s)
+void token::set_prog_value(string_view s)
 {
-	if(sym->get_sym() == symbol::program_sym)
-		prog_value = s;
+	if(sym.get_sym() == symbol::program_sym)
+	{
+		text = s.data();
+		text_length = s.length();
+	}
 	else throw lille_exception("Illegal attempt to set prog_value in token");
 }
 
-void token::set_string_value(string s)
+void token::set_string_value(string_view s)
 // Set the string_value to s only if the token represents a string_value. Raise an exception otherwise.
 {
-	if (sym->get_sym() == symbol::strng)
-		string_value = s;
+	if (sym.get_sym() == symbol::strng)
+	{
+		text = s.data();
+		text_length = s.length();
+	}
 	else
 		throw lille_exception("Illegal attempt to set string_value in token");
 }
 
 
-void token::set_identifier_value(string s)
+int token::get_identifier_atom()
+// returns the atom of the identifier, or atom_table::no_atom if the symbol is not an identifier.
+{
+	if (sym.get_sym() == symbol::identifier)
+		return atom;
+	else
+		return atom_table::no_atom;
+}
+
+
+void token::set_identifier_value(string_view s)
 // Set the identifier_value to s only if the token represents an identifier. Raise an exception otherwise.
 {
-	if (sym->get_sym() == symbol::identifier)
-		identifier_value = s;
+	set_identifier_atom(atom_table::intern(s));
+}
+
+
+void token::set_identifier_atom(int a)
+// Set the identifier to the name of atom a only if the token represents an identifier. Raise an exception otherwise.
+{
+	if (sym.get_sym() == symbol::identifier)
+		atom = a;
 	else
 		throw lille_exception("Illegal attempt to set identifier_value in token");
 }
@@ -193,15 +197,15 @@ void token::set_identifier_value(string s)
 
 void token::print_token()
 {
-	cout << "TOKEN: " << sym->symtostr();
-	if (sym->get_sym() == symbol::real_num)
+	cout << "TOKEN: " << sym.symtostr();
+	if (sym.get_sym() == symbol::real_num)
 		cout << "  Value: " << real_value;
-	else if (sym->get_sym() == symbol::integer)
+	else if (sym.get_sym() == symbol::integer)
 		cout << "  Value: " << integer_value;
-	else if (sym->get_sym() == symbol::strng)
-		cout << "  Value: " << string_value;
-	else if (sym->get_sym() == symbol::identifier)
-		cout << "  Value: " << identifier_value;
+	else if (sym.get_sym() == symbol::strng)
+		cout << "  Value: " << get_string_value();
+	else if (sym.get_sym() == symbol::identifier)
+		cout << "  Value: " << get_identifier_value();
 	cout << "  Line No: " << line_number << " Pos on line: " << pos_on_line << endl;
 }
 
@@ -209,7 +213,7 @@ void token::print_token()
 string token::to_string()
 {
 	string s = "";
-	s += "Name: " + this->identifier_value;
+	s += "Name: " + string(get_identifier_value());
 	s += " Line No: " + ::to_string(line_number);
 	s += " Position: " + ::to_string(pos_on_line);
 	return s;
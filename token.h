@@ -9,46 +9,52 @@
 #define TOKEN_H_
 
 #include <string>
+#include <string_view>
 
 #include "symbol.h"
 #include "lille_exception.h"
+#include "atom_table.h"
 
 using namespace std;
 
 
 class token {
 private:
-	symbol* sym;				// Symbol identified.
+	symbol sym;					// Symbol identified.
 	int line_number;			// Line number in source file where symbol is located.
 	int pos_on_line;			// Position on line in source file where the symbol is located.
-	float real_value;			// If symbol represents a real number, this is its value.
-	int integer_value;			// If symbol represents an integer value, this is its value.
-	string string_value;		// If symbol represents a string value, this is its value.
-	string identifier_value;	// If the symbol represents an identifier, this is its name.
-	string prog_value;
+	int text_length;			// Length of text, if the token carries text.
+	union {						// Only one value is ever meaningful; which one is determined by the symbol.
+		float real_value;		// If symbol represents a real number, this is its value.
+		int integer_value;		// If symbol represents an integer value, this is its value.
+		int atom;				// If symbol represents an identifier, this is the atom of its name. See atom_table.h.
+		const char* text;		// If symbol represents a string or the program name, this is its text.
+								// The text is not owned by the token. It is a view into the source buffer or into
+								// text kept by the token arena.
+	};
 
 public:
 	token();
-	token(symbol* s, int line, int pos);	// create a token - constructor.
-
-	token(const token& t);		// copy constructor
-	token& operator=(const token& t);	// copy assignment
+	token(symbol s, int line, int pos);	// create a token - constructor.
 
 	symbol::symbol_type get_sym();			// returns the symbol.
-	symbol* get_symbol();
+	symbol get_symbol();
 	int get_line_number();		// returns the line number
 	int get_pos_on_line();		// returns the position on the line;
 	float get_real_value();		// returns the real only if the symbol is a real_number. Raises a DO_exceeption otherwise.
 	int get_integer_value();	// returns the integer_value only if the symbol is a integer_number. Raises a DO_exceeption otherwise.
-        string get_prog_value();
-	string get_string_value();	// returns the string_value only if the symbol is a string. Raises a DO_exceeption otherwise.
-	string get_identifier_value(); // returns the string_value only if the symbol is an identifier. Raises a Lille_exceeption otherwise.
+        string_view get_prog_value();
+	string_view get_string_value();	// returns the string_value only if the symbol is a string. Raises a DO_exceeption otherwise.
+	string_view get_identifier_value(); // returns the string_value only if the symbol is an identifier. Raises a Lille_exceeption otherwise.
+	int get_identifier_atom();	// returns the atom of the identifier, or atom_table::no_atom if the symbol is not an identifier.
 
+	// The text passed to the following setters must outlive the token.
 	void set_real_value(float f); 	// Set the real_value to f only if the token represents a real_value. Raise an exception otherwise.
 	void set_integer_value(int i);	// Set the ingteger_value to i only if the token represents a integer_value. Raise an exception otherwise.
-	void set_prog_value(string s);
-	void set_string_value(string s);	// Set the string_value to s only if the token represents a string_value. Raise an exception otherwise.
-	void set_identifier_value(string s);	// Set the identifier_value to s only if the token represents an identifier. Raise an exception otherwise.
+	void set_prog_value(string_view s);
+	void set_string_value(string_view s);	// Set the string_value to s only if the token represents a string_value. Raise an exception otherwise.
+	void set_identifier_value(string_view s);	// Set the identifier_value to s only if the token represents an identifier. Raise an exception otherwise.
+	void set_identifier_atom(int a);	// Set the identifier to the name of atom a only if the token represents an identifier. Raise an exception otherwise.
 
 	void print_token();			// print out the token. Helpful for debugging.
 
@@ -0,0 +1,114 @@
+/*
+ * token_arena.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: McHale Trotter
+ */
+
+#include <new>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <string_view>
+
+#include "symbol.h"
+#include "token.h"
+#include "token_arena.h"
+
+using namespace std;
+
+
+token_arena::token_arena()
+// Constructor. No storage is reserved until the first token is allocated.
+{
+	used = block_size;
+	text_used = text_block_size;
+}
+
+
+token_arena::~token_arena()
+// Destructor.
+{
+	release();
+}
+
+
+token* token_arena::next_slot()
+// Bump allocate storage for one token.
+{
+	if (used == block_size)
+	{
+		blocks.push_back(static_cast<token*>(::operator new(block_size * sizeof(token))));
+		used = 0;
+	}
+	return blocks.back() + used;
+}
+
+
+token* token_arena::allocate()
+{
+	token* t = new (next_slot()) token();
+	used++;
+	return t;
+}
+
+
+token* token_arena::allocate(symbol s, int line, int pos)
+{
+	token* t = new (next_slot()) token(s, line, pos);
+	used++;
+	return t;
+}
+
+
+string_view token_arena::keep_text(string_view s)
+// Bump allocate a copy of s. Text too long for a block gets a block of its own.
+{
+	char* copy;
+
+	if (s.empty())
+		return string_view();
+	else if (s.length() > text_block_size)
+	{
+		text_blocks.insert(text_blocks.begin(), make_unique<char[]>(s.length()));
+		copy = text_blocks.front().get();
+	}
+	else
+	{
+		if (text_used + s.length() > text_block_size)
+		{
+			text_blocks.push_back(make_unique<char[]>(text_block_size));
+			text_used = 0;
+		}
+		copy = text_blocks.back().get() + text_used;
+		text_used += s.length();
+	}
+	memcpy(copy, s.data(), s.length());
+	return string_view(copy, s.length());
+}
+
+
+void token_arena::release()
+// Destroy every token and free all blocks.
+{
+	for (size_t b = 0; b < blocks.size(); b++)
+	{
+		int count = (b + 1 == blocks.size()) ? used : block_size;
+		for (int i = 0; i < count; i++)
+			blocks[b][i].~token();
+		::operator delete(blocks[b]);
+	}
+	blocks.clear();
+	used = block_size;
+	text_blocks.clear();
+	text_used = text_block_size;
+}
+
+
+size_t token_arena::size()
+{
+	if (blocks.empty())
+		return 0;
+	else
+		return (blocks.size() - 1) * block_size + used;
+}
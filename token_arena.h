@@ -0,0 +1,53 @@
+/*
+ * token_arena.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: McHale Trotter
+ */
+
+#ifndef TOKEN_ARENA_H_
+#define TOKEN_ARENA_H_
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <string_view>
+
+#include "symbol.h"
+#include "token.h"
+
+using namespace std;
+
+class token_arena {
+private:
+	static const int block_size = 1024;	// Number of tokens held in each block of the arena.
+
+	vector<token*> blocks;			// Blocks of raw storage. Every block but the last is full.
+	int used;						// Number of tokens constructed in the last block.
+
+	static const size_t text_block_size = 65536;	// Number of characters held in each block of kept text.
+	vector<unique_ptr<char[]>> text_blocks;	// Text that tokens refer to but that is not in the source buffer.
+	size_t text_used;				// Number of characters used in the last text block.
+
+	token* next_slot();				// Storage for one more token, starting a new block if the last one is full.
+
+public:
+	token_arena();
+	~token_arena();					// Destroys every token in the arena.
+
+	token_arena(const token_arena&) = delete;
+	token_arena& operator=(const token_arena&) = delete;
+
+	token* allocate();
+	token* allocate(symbol s, int line, int pos);
+	// Create a token in the arena. The token stays valid until the arena is released or destroyed,
+	// so it may be kept by the parser and the identifier table for the whole compilation.
+
+	string_view keep_text(string_view s);
+	// Copy s into the arena so that tokens may refer to it. The copy stays valid as long as the tokens do.
+
+	void release();					// Destroy every token and kept text in the arena and return its storage in one operation.
+	size_t size();					// Number of tokens currently held in the arena.
+};
+
+#endif /* TOKEN_ARENA_H_ */